@@ -0,0 +1,591 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Headless benchmark for KGP_EQAudioProcessor. Runs the processor without
+    an editor over sweeps of sample rate, block size, slope, bypass state,
+    processing mode, filter topology and parameter automation, and reports
+    the average cost per sample, the worst block and any allocations made on
+    the thread that calls processBlock.
+
+    Usage: KGP_EQ_Benchmark [--seconds <audio seconds per case>] [--quick]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+#include "../../Source/ResponseCurve.h"
+
+#include <array>
+#include <atomic>
+#include <complex>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <new>
+
+#if KGP_EQ_TRAP_AUDIO_THREAD_ALLOCATIONS
+ #error "The plugin's allocation trap replaces operator new as well, build the benchmark without it"
+#endif
+
+//==============================================================================
+// Every allocation goes through these, but only the ones made while the
+// benchmark thread is inside the processor are counted
+namespace {
+    thread_local bool countingAllocations = false;
+    std::atomic<juce::int64> audioThreadAllocations{ 0 };
+
+    void* allocate(std::size_t size) {
+        if (countingAllocations)
+            audioThreadAllocations.fetch_add(1, std::memory_order_relaxed);
+
+        if (auto* ptr = std::malloc(size == 0 ? 1 : size))
+            return ptr;
+
+        throw std::bad_alloc();
+    }
+
+    struct ScopedAllocationCounter {
+        ScopedAllocationCounter() { countingAllocations = true; }
+        ~ScopedAllocationCounter() { countingAllocations = false; }
+    };
+}
+
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { try { return allocate(size); } catch (...) { return nullptr; } }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { try { return allocate(size); } catch (...) { return nullptr; } }
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+
+//==============================================================================
+namespace {
+    constexpr int numChannels = 2;
+
+    // Long enough that the input never repeats inside one block
+    constexpr int inputLengthSamples = 1 << 16;
+
+    // Blocks run before measuring, so coefficient designs and kernels have landed
+    constexpr double warmUpSeconds = 0.5;
+
+    enum class Automation {
+        none,
+        slowSweep,      // Peak and cut frequencies glide, as when a host plays back a drawn curve
+        jumpEveryBlock, // Every band's frequency and gain jump to a new value on every block
+        slopeChanges    // Cut slopes change every block, so cascades are redesigned constantly
+    };
+
+    const char* getAutomationName(Automation automation) {
+        switch (automation) {
+        case Automation::slowSweep: return "slow sweep";
+        case Automation::jumpEveryBlock: return "jump every block";
+        case Automation::slopeChanges: return "slope changes";
+        case Automation::none:
+        default: return "static";
+        }
+    }
+
+    struct Scenario {
+        juce::String group;
+        double sampleRate{ 48000.0 };
+        int blockSize{ 512 };
+
+        Slope lowCutSlope{ Slope::slope12 }, highCutSlope{ Slope::slope12 };
+        bool lowCutBypassed{ false }, peakBypassed{ false }, highCutBypassed{ false };
+        int numParametricBands{ 0 };
+
+        // Index into the "Phase Mode" / "Oversampling" choices
+        int phaseMode{ 0 }, oversampling{ 0 };
+
+        // Applied to all three fixed bands
+        FilterTopology topology{ FilterTopology::tdf2Float };
+
+        Automation automation{ Automation::none };
+    };
+
+    struct Result {
+        double nanosecondsPerSample{ 0.0 };
+        double worstBlockMicroseconds{ 0.0 };
+        double worstBlockLoad{ 0.0 };   // Worst block time over the block period
+        juce::int64 allocations{ 0 };
+        juce::int64 allocatingBlocks{ 0 };
+        int numBlocks{ 0 };
+    };
+
+    juce::RangedAudioParameter* getParameter(juce::AudioProcessorValueTreeState& apvts, juce::StringRef parameterID) {
+        auto* parameter = apvts.getParameter(parameterID);
+        jassert(parameter != nullptr);
+
+        return parameter;
+    }
+
+    void setParameter(juce::RangedAudioParameter* parameter, float value) {
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    }
+
+    void setParameter(juce::AudioProcessorValueTreeState& apvts, juce::StringRef parameterID, float value) {
+        setParameter(getParameter(apvts, parameterID), value);
+    }
+
+    // Looked up before the measured blocks, so the only allocations counted while automating
+    // come from the processor's parameter listeners and not from building IDs or searching them
+    struct AutomatedParameters {
+        explicit AutomatedParameters(juce::AudioProcessorValueTreeState& apvts) :
+            peakFrequency(getParameter(apvts, "Peak Frequency")),
+            peakGain(getParameter(apvts, "Peak Gain")),
+            lowCutFrequency(getParameter(apvts, "Low-Cut Frequency")),
+            highCutFrequency(getParameter(apvts, "High-Cut Frequency")),
+            lowCutSlope(getParameter(apvts, "Low-Cut Slope")),
+            highCutSlope(getParameter(apvts, "High-Cut Slope"))
+        {
+            for (int i = 0; i < maxParametricBands; ++i) {
+                const auto& ids = getParametricBandParameterIDs(i);
+                bandFrequencies[(size_t)i] = getParameter(apvts, ids.frequency);
+                bandGains[(size_t)i] = getParameter(apvts, ids.gain);
+            }
+        }
+
+        juce::RangedAudioParameter* peakFrequency;
+        juce::RangedAudioParameter* peakGain;
+        juce::RangedAudioParameter* lowCutFrequency;
+        juce::RangedAudioParameter* highCutFrequency;
+        juce::RangedAudioParameter* lowCutSlope;
+        juce::RangedAudioParameter* highCutSlope;
+
+        std::array<juce::RangedAudioParameter*, maxParametricBands> bandFrequencies{};
+        std::array<juce::RangedAudioParameter*, maxParametricBands> bandGains{};
+    };
+
+    void applyScenario(juce::AudioProcessorValueTreeState& apvts, const Scenario& scenario) {
+        setParameter(apvts, "Low-Cut Frequency", 80.f);
+        setParameter(apvts, "High-Cut Frequency", 12000.f);
+        setParameter(apvts, "Peak Frequency", 1000.f);
+        setParameter(apvts, "Peak Gain", 6.f);
+        setParameter(apvts, "Peak Quality", 1.f);
+
+        setParameter(apvts, "Low-Cut Slope", (float)scenario.lowCutSlope);
+        setParameter(apvts, "High-Cut Slope", (float)scenario.highCutSlope);
+
+        setParameter(apvts, "Low-Cut Bypassed", scenario.lowCutBypassed ? 1.f : 0.f);
+        setParameter(apvts, "Peak Bypassed", scenario.peakBypassed ? 1.f : 0.f);
+        setParameter(apvts, "High-Cut Bypassed", scenario.highCutBypassed ? 1.f : 0.f);
+
+        setParameter(apvts, "Low-Cut Topology", (float)scenario.topology);
+        setParameter(apvts, "Peak Topology", (float)scenario.topology);
+        setParameter(apvts, "High-Cut Topology", (float)scenario.topology);
+
+        // Nobody reads the analyzer here, but it stays enabled as it would be in a session
+        setParameter(apvts, "Analyzer Enabled", 1.f);
+        setParameter(apvts, "Test Signal", 0.f);
+
+        setParameter(apvts, "Phase Mode", (float)scenario.phaseMode);
+        setParameter(apvts, "Oversampling", (float)scenario.oversampling);
+
+        for (int i = 0; i < maxParametricBands; ++i) {
+            const auto& ids = getParametricBandParameterIDs(i);
+
+            // Spread the bands over the spectrum, alternating boosts and cuts
+            setParameter(apvts, ids.frequency, 40.f * std::pow(2.f, (float)i * 0.6f));
+            setParameter(apvts, ids.gain, (i % 2 == 0) ? 3.f : -3.f);
+            setParameter(apvts, ids.quality, 2.f);
+            setParameter(apvts, ids.type, (float)(i % 4));
+            setParameter(apvts, ids.byPassed, i < scenario.numParametricBands ? 0.f : 1.f);
+        }
+    }
+
+    // Called before each block, on the same thread, which is where hosts deliver automation
+    void automate(const AutomatedParameters& parameters, const Scenario& scenario, int block, juce::Random& random) {
+        switch (scenario.automation) {
+        case Automation::slowSweep: {
+            auto position = (float)(block % 512) / 512.f;
+            setParameter(parameters.peakFrequency, 200.f * std::pow(40.f, position));
+            setParameter(parameters.lowCutFrequency, 20.f + 180.f * position);
+            setParameter(parameters.highCutFrequency, 20000.f - 15000.f * position);
+            break;
+        }
+        case Automation::jumpEveryBlock:
+            setParameter(parameters.peakFrequency, 20.f * std::pow(1000.f, random.nextFloat()));
+            setParameter(parameters.peakGain, random.nextFloat() * 48.f - 24.f);
+            setParameter(parameters.lowCutFrequency, 20.f * std::pow(50.f, random.nextFloat()));
+            setParameter(parameters.highCutFrequency, 1000.f * std::pow(20.f, random.nextFloat()));
+
+            for (int i = 0; i < scenario.numParametricBands; ++i) {
+                setParameter(parameters.bandFrequencies[(size_t)i], 20.f * std::pow(1000.f, random.nextFloat()));
+                setParameter(parameters.bandGains[(size_t)i], random.nextFloat() * 48.f - 24.f);
+            }
+            break;
+        case Automation::slopeChanges:
+            setParameter(parameters.lowCutSlope, (float)(block % 4));
+            setParameter(parameters.highCutSlope, (float)((block + 2) % 4));
+            break;
+        case Automation::none:
+        default:
+            break;
+        }
+    }
+
+    juce::AudioBuffer<float> makeInput() {
+        juce::AudioBuffer<float> input(numChannels, inputLengthSamples);
+        juce::Random random(0x4b4750);
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            auto* data = input.getWritePointer(channel);
+            for (int i = 0; i < inputLengthSamples; ++i)
+                data[i] = (random.nextFloat() * 2.f - 1.f) * 0.25f;
+        }
+
+        return input;
+    }
+
+    Result run(const Scenario& scenario, const juce::AudioBuffer<float>& input, double secondsPerCase) {
+        KGP_EQAudioProcessor processor;
+        auto& apvts = processor.apvts;
+
+        applyScenario(apvts, scenario);
+        const AutomatedParameters automatedParameters(apvts);
+
+        processor.setPlayConfigDetails(numChannels, numChannels, scenario.sampleRate, scenario.blockSize);
+        processor.prepareToPlay(scenario.sampleRate, scenario.blockSize);
+
+        juce::AudioBuffer<float> buffer(numChannels, scenario.blockSize);
+        juce::MidiBuffer midi;
+        juce::Random random(1);
+
+        int inputPosition = 0;
+        auto fillBlock = [&] {
+            if (inputPosition + scenario.blockSize > inputLengthSamples)
+                inputPosition = 0;
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                buffer.copyFrom(channel, 0, input, channel, inputPosition, scenario.blockSize);
+
+            inputPosition += scenario.blockSize;
+        };
+
+        const auto warmUpBlocks = juce::roundToInt(warmUpSeconds * scenario.sampleRate / scenario.blockSize) + 1;
+        for (int block = 0; block < warmUpBlocks; ++block) {
+            fillBlock();
+            automate(automatedParameters, scenario, block, random);
+            processor.processBlock(buffer, midi);
+        }
+
+        // Linear phase kernels are handed over on the convolution's loader thread
+        if (scenario.phaseMode != 0)
+            juce::Thread::sleep(200);
+
+        Result result;
+        result.numBlocks = juce::jmax(1, juce::roundToInt(secondsPerCase * scenario.sampleRate / scenario.blockSize));
+
+        const auto blockPeriodSeconds = scenario.blockSize / scenario.sampleRate;
+        double totalSeconds = 0.0, worstSeconds = 0.0;
+
+        for (int block = 0; block < result.numBlocks; ++block) {
+            fillBlock();
+
+            auto allocationsBefore = audioThreadAllocations.load();
+            juce::int64 start, end;
+
+            {
+                ScopedAllocationCounter counter;
+                automate(automatedParameters, scenario, warmUpBlocks + block, random);
+
+                start = juce::Time::getHighResolutionTicks();
+                processor.processBlock(buffer, midi);
+                end = juce::Time::getHighResolutionTicks();
+            }
+
+            auto allocations = audioThreadAllocations.load() - allocationsBefore;
+            result.allocations += allocations;
+            result.allocatingBlocks += allocations > 0 ? 1 : 0;
+
+            auto seconds = juce::Time::highResolutionTicksToSeconds(end - start);
+            totalSeconds += seconds;
+            worstSeconds = juce::jmax(worstSeconds, seconds);
+        }
+
+        processor.releaseResources();
+
+        result.nanosecondsPerSample = totalSeconds * 1.0e9 / ((double)result.numBlocks * scenario.blockSize);
+        result.worstBlockMicroseconds = worstSeconds * 1.0e6;
+        result.worstBlockLoad = worstSeconds / blockPeriodSeconds;
+
+        return result;
+    }
+
+    juce::String describe(const Scenario& scenario) {
+        static const char* slopes[] = { "12", "24", "36", "48" };
+        static const char* phaseModes[] = { "min", "lin" };
+        static const char* oversampling[] = { "1x", "2x", "4x" };
+        static const char* topologies[] = { "f32", "f64", "svf" };
+
+        juce::String bypass;
+        bypass << (scenario.lowCutBypassed ? "-" : "L")
+               << (scenario.peakBypassed ? "-" : "P")
+               << (scenario.highCutBypassed ? "-" : "H");
+
+        juce::String text;
+        text << slopes[scenario.lowCutSlope] << "/" << slopes[scenario.highCutSlope] << " dB "
+             << bypass << " +" << scenario.numParametricBands << " "
+             << phaseModes[scenario.phaseMode] << " " << oversampling[scenario.oversampling] << " "
+             << topologies[scenario.topology] << " " << getAutomationName(scenario.automation);
+
+        return text;
+    }
+
+    void printHeader() {
+        std::cout << juce::String("group").paddedRight(' ', 12)
+                  << juce::String("rate").paddedLeft(' ', 8)
+                  << juce::String("block").paddedLeft(' ', 7)
+                  << "  " << juce::String("configuration").paddedRight(' ', 46)
+                  << juce::String("ns/sample").paddedLeft(' ', 11)
+                  << juce::String("worst us").paddedLeft(' ', 11)
+                  << juce::String("worst %").paddedLeft(' ', 9)
+                  << juce::String("allocs").paddedLeft(' ', 9)
+                  << juce::String("alloc blk").paddedLeft(' ', 11)
+                  << std::endl;
+    }
+
+    void printResult(const Scenario& scenario, const Result& result) {
+        std::cout << scenario.group.paddedRight(' ', 12)
+                  << juce::String(scenario.sampleRate, 0).paddedLeft(' ', 8)
+                  << juce::String(scenario.blockSize).paddedLeft(' ', 7)
+                  << "  " << describe(scenario).paddedRight(' ', 46)
+                  << juce::String(result.nanosecondsPerSample, 2).paddedLeft(' ', 11)
+                  << juce::String(result.worstBlockMicroseconds, 1).paddedLeft(' ', 11)
+                  << juce::String(result.worstBlockLoad * 100.0, 1).paddedLeft(' ', 9)
+                  << juce::String(result.allocations).paddedLeft(' ', 9)
+                  << (juce::String(result.allocatingBlocks) + "/" + juce::String(result.numBlocks)).paddedLeft(' ', 11)
+                  << std::endl;
+    }
+
+    std::vector<Scenario> makeScenarios(bool quick) {
+        std::vector<Scenario> scenarios;
+
+        const std::vector<double> sampleRates = quick ? std::vector<double>{ 48000.0 }
+                                                      : std::vector<double>{ 44100.0, 48000.0, 96000.0, 192000.0 };
+
+        std::vector<int> blockSizes;
+        for (int blockSize = 16; blockSize <= 4096; blockSize *= (quick ? 4 : 2))
+            blockSizes.push_back(blockSize);
+
+        Scenario base;
+
+        // Cost per sample against block size and rate with every band in use
+        for (auto sampleRate : sampleRates) {
+            for (auto blockSize : blockSizes) {
+                auto scenario = base;
+                scenario.group = "block size";
+                scenario.sampleRate = sampleRate;
+                scenario.blockSize = blockSize;
+                scenarios.push_back(scenario);
+            }
+        }
+
+        // Every bypass combination, at the cheapest and the steepest slope
+        for (auto slope : { Slope::slope12, Slope::slope48 }) {
+            for (int bypassMask = 0; bypassMask < 8; ++bypassMask) {
+                auto scenario = base;
+                scenario.group = "bypass";
+                scenario.lowCutSlope = scenario.highCutSlope = slope;
+                scenario.lowCutBypassed = (bypassMask & 1) != 0;
+                scenario.peakBypassed = (bypassMask & 2) != 0;
+                scenario.highCutBypassed = (bypassMask & 4) != 0;
+                scenarios.push_back(scenario);
+            }
+        }
+
+        for (auto numBands : { 4, maxParametricBands }) {
+            auto scenario = base;
+            scenario.group = "parametric";
+            scenario.lowCutSlope = scenario.highCutSlope = Slope::slope48;
+            scenario.numParametricBands = numBands;
+            scenarios.push_back(scenario);
+        }
+
+        // Float TDF-II against the double precision TDF-II and SVF paths
+        for (auto slope : { Slope::slope12, Slope::slope48 }) {
+            for (auto topology : { FilterTopology::tdf2Float, FilterTopology::tdf2Double, FilterTopology::svfDouble }) {
+                auto scenario = base;
+                scenario.group = "topology";
+                scenario.lowCutSlope = scenario.highCutSlope = slope;
+                scenario.topology = topology;
+                scenarios.push_back(scenario);
+            }
+        }
+
+        // Minimum phase at each oversampling factor, then linear phase
+        for (int oversampling = 0; oversampling < 3; ++oversampling) {
+            auto scenario = base;
+            scenario.group = "mode";
+            scenario.lowCutSlope = scenario.highCutSlope = Slope::slope48;
+            scenario.oversampling = oversampling;
+            scenarios.push_back(scenario);
+        }
+
+        {
+            auto scenario = base;
+            scenario.group = "mode";
+            scenario.lowCutSlope = scenario.highCutSlope = Slope::slope48;
+            scenario.phaseMode = 1;
+            scenarios.push_back(scenario);
+        }
+
+        // Small blocks are where per block design and smoothing costs show up
+        for (auto automation : { Automation::slowSweep, Automation::jumpEveryBlock, Automation::slopeChanges }) {
+            for (auto blockSize : { 32, 128, 512 }) {
+                auto scenario = base;
+                scenario.group = "automation";
+                scenario.blockSize = blockSize;
+                scenario.lowCutSlope = scenario.highCutSlope = Slope::slope48;
+                scenario.numParametricBands = automation == Automation::jumpEveryBlock ? maxParametricBands : 0;
+                scenario.automation = automation;
+                scenarios.push_back(scenario);
+            }
+        }
+
+        return scenarios;
+    }
+
+    //==============================================================================
+    // The editor's response curve: every band of a busy preset evaluated at one frequency
+    // per column, by computeMagnitudesInDecibels and by a per frequency complex evaluation
+    // like juce::dsp::IIR::Coefficients::getMagnitudeForFrequency
+    constexpr int curveColumns = 1200;
+    constexpr double curveSampleRate = 48000.0;
+
+    std::vector<BiquadCoefficients> makeCurveSections() {
+        std::vector<BiquadCoefficients> sections;
+
+        auto addCascade = [&](const CascadeCoefficients& cascade) {
+            sections.insert(sections.end(), cascade.stages.begin(), cascade.stages.begin() + cascade.numStages);
+        };
+
+        addCascade(designButterworthHighPass(curveSampleRate, 80.0, 8));
+        addCascade(designPeak(curveSampleRate, 1000.0, 1.0, juce::Decibels::decibelsToGain(6.0)));
+        addCascade(designButterworthLowPass(curveSampleRate, 12000.0, 8));
+
+        for (int i = 0; i < maxParametricBands; ++i)
+            sections.push_back(designPeakBiquad(curveSampleRate, 40.0 * std::pow(2.0, i * 0.6), 2.0,
+                                                juce::Decibels::decibelsToGain((i % 2 == 0) ? 3.0 : -3.0)));
+
+        return sections;
+    }
+
+    void evaluateCurveReference(const std::vector<float>& frequencies, const std::vector<BiquadCoefficients>& sections,
+                                float* decibelsOut) {
+        for (size_t i = 0; i < frequencies.size(); ++i) {
+            auto z = std::polar(1.0, -juce::MathConstants<double>::twoPi * frequencies[i] / curveSampleRate);
+            auto z2 = z * z;
+
+            double magnitude = 1.0;
+            for (const auto& c : sections)
+                magnitude *= std::abs((c.b0 + c.b1 * z + c.b2 * z2) / (1.0 + c.a1 * z + c.a2 * z2));
+
+            decibelsOut[i] = juce::Decibels::gainToDecibels((float)magnitude, -200.f);
+        }
+    }
+
+    // Fastest of several runs, in microseconds per evaluation of the whole curve
+    template<typename Function>
+    double timeCurve(Function&& evaluate) {
+        constexpr int runs = 50, evaluationsPerRun = 20;
+        double best = std::numeric_limits<double>::max();
+
+        for (int run = 0; run < runs; ++run) {
+            auto start = juce::Time::getHighResolutionTicks();
+
+            for (int i = 0; i < evaluationsPerRun; ++i)
+                evaluate();
+
+            auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+            best = juce::jmin(best, seconds * 1.0e6 / evaluationsPerRun);
+        }
+
+        return best;
+    }
+
+    void runResponseCurveBenchmark() {
+        const auto sections = makeCurveSections();
+        const auto numSections = (int)sections.size();
+
+        std::vector<float> frequencies(curveColumns), halfAngleSines(curveColumns);
+        for (int i = 0; i < curveColumns; ++i)
+            frequencies[(size_t)i] = (float)juce::mapToLog10(double(i) / double(curveColumns), 20.0, 20000.0);
+
+        computeHalfAngleSines(frequencies.data(), curveColumns, curveSampleRate, halfAngleSines.data());
+
+        std::vector<float> batch(curveColumns), reference(curveColumns);
+
+        auto batchMicroseconds = timeCurve([&] {
+            computeMagnitudesInDecibels(halfAngleSines.data(), curveColumns, sections.data(), numSections, batch.data());
+        });
+
+        auto referenceMicroseconds = timeCurve([&] { evaluateCurveReference(frequencies, sections, reference.data()); });
+
+        float worstError = 0.f;
+        for (int i = 0; i < curveColumns; ++i) {
+            if (reference[(size_t)i] > -150.f)
+                worstError = juce::jmax(worstError, std::abs(batch[(size_t)i] - reference[(size_t)i]));
+        }
+
+        std::cout << "Response curve, " << curveColumns << " columns x " << numSections << " sections: "
+                  << juce::String(batchMicroseconds, 1) << " us batch ("
+                  << juce::String(batchMicroseconds * 1000.0 / (curveColumns * numSections), 2) << " ns per column and section), "
+                  << juce::String(referenceMicroseconds, 1) << " us complex reference, "
+                  << juce::String(referenceMicroseconds / batchMicroseconds, 1) << "x, worst difference "
+                  << juce::String(worstError, 4) << " dB" << std::endl;
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[]) {
+    // The parameter attachments and the convolution's loader expect JUCE to be initialised
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    double secondsPerCase = 5.0;
+    bool quick = false;
+
+    for (int i = 1; i < argc; ++i) {
+        juce::String argument(argv[i]);
+
+        if (argument == "--seconds" && i + 1 < argc)
+            secondsPerCase = juce::jmax(0.1, juce::String(argv[++i]).getDoubleValue());
+        else if (argument == "--quick")
+            quick = true;
+        else {
+            std::cout << "Usage: KGP_EQ_Benchmark [--seconds <audio seconds per case>] [--quick]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (quick)
+        secondsPerCase = juce::jmin(secondsPerCase, 1.0);
+
+    std::cout << "KGP_EQ processor benchmark, " << secondsPerCase << " s of audio per case, "
+              << numChannels << " channels" << std::endl << std::endl;
+
+    const auto input = makeInput();
+    printHeader();
+
+    juce::int64 totalAllocations = 0;
+
+    for (const auto& scenario : makeScenarios(quick)) {
+        auto result = run(scenario, input, secondsPerCase);
+        printResult(scenario, result);
+
+        totalAllocations += result.allocations;
+    }
+
+    std::cout << std::endl;
+    runResponseCurveBenchmark();
+
+    std::cout << std::endl << "Audio thread allocations: " << totalAllocations << std::endl;
+    return totalAllocations == 0 ? 0 : 2;
+}
@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+    AnalyzerScheduler.cpp
+
+  ==============================================================================
+*/
+
+#include "AnalyzerScheduler.h"
+
+AnalyzerScheduler::AnalyzerScheduler() = default;
+
+AnalyzerScheduler::~AnalyzerScheduler() {
+    jassert(clients.isEmpty());
+    stopTimer();
+}
+
+void AnalyzerScheduler::addClient(Client* client) {
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    clients.addIfNotAlreadyThere(client);
+
+    if (!isTimerRunning())
+        startTimerHz(frameRateHz);
+}
+
+void AnalyzerScheduler::removeClient(Client* client) {
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    clients.removeFirstMatchingValue(client);
+
+    pool.removeJob(&client->getAnalyzerJob(), true, -1);
+
+    if (clients.isEmpty())
+        stopTimer();
+}
+
+void AnalyzerScheduler::vblank() {
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    auto now = juce::Time::getMillisecondCounterHiRes();
+    if (now - lastVBlankMs < minimumVBlankIntervalMs)
+        return;
+
+    lastVBlankMs = now;
+    tick();
+}
+
+void AnalyzerScheduler::timerCallback() {
+    if (juce::Time::getMillisecondCounterHiRes() - lastVBlankMs < vblankTimeoutMs)
+        return;
+
+    tick();
+}
+
+void AnalyzerScheduler::tick() {
+    for (auto* client : clients) {
+        if (!client->isAnalyzerVisible())
+            continue;
+
+        // A client whose previous job is still running simply skips a frame
+        auto* job = &client->getAnalyzerJob();
+        if (client->analyzerFrame() && !pool.contains(job))
+            pool.addJob(job, false);
+    }
+}
@@ -0,0 +1,64 @@
+/*
+  ==============================================================================
+
+    AnalyzerScheduler.h
+
+    One analyzer clock and worker pool shared by every editor in the process.
+    Editors register as clients; hidden or minimised ones are skipped, so the
+    analyzer cost follows the number of visible editors, not loaded instances.
+    Editors forward their display's vertical blank to vblank(), so frames line
+    up with the screen refresh. A 60 Hz timer takes over when no vblank
+    arrives, e.g. on JUCE 6 or on hosts whose windows never get one.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class AnalyzerScheduler : private juce::Timer {
+public:
+    struct Client {
+        virtual ~Client() = default;
+
+        // Message thread. Clients that return false get no frame and no job this tick.
+        virtual bool isAnalyzerVisible() = 0;
+
+        // Message thread, once per tick: collect finished results and repaint.
+        // Returning true queues the client's job to produce the next frame.
+        virtual bool analyzerFrame() = 0;
+
+        virtual juce::ThreadPoolJob& getAnalyzerJob() = 0;
+    };
+
+    AnalyzerScheduler();
+    ~AnalyzerScheduler() override;
+
+    // Message thread only. removeClient waits for the client's job to finish.
+    void addClient(Client* client);
+    void removeClient(Client* client);
+
+    // Message thread. Several editors on one display report the same vblank, so
+    // calls closer together than minimumVBlankIntervalMs count as one.
+    void vblank();
+
+    static constexpr int frameRateHz = 60;
+    static constexpr int numWorkerThreads = 2;
+
+    static constexpr double minimumVBlankIntervalMs = 4.0;
+
+    // The timer stays quiet while vblanks have arrived within this long
+    static constexpr double vblankTimeoutMs = 3000.0 / frameRateHz;
+
+private:
+    void timerCallback() override;
+    void tick();
+
+    double lastVBlankMs = 0.0;
+
+    juce::Array<Client*> clients;
+    juce::ThreadPool pool{ numWorkerThreads };
+
+    JUCE_DECLARE_NON_COPYABLE(AnalyzerScheduler)
+};
@@ -0,0 +1,179 @@
+/*
+  ==============================================================================
+
+    AudioThreadMonitor.cpp
+
+  ==============================================================================
+*/
+
+#include "AudioThreadMonitor.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+namespace {
+    thread_local int audioCallbackDepth = 0;
+
+    // Set while a trap reports itself, since the assertion may allocate too
+    thread_local bool reportingTrap = false;
+
+    std::atomic<juce::int64> trappedAllocations{ 0 };
+
+    void trapAllocation() noexcept {
+        if (audioCallbackDepth == 0 || reportingTrap)
+            return;
+
+        trappedAllocations.fetch_add(1, std::memory_order_relaxed);
+
+        const juce::ScopedValueSetter<bool> reporting(reportingTrap, true);
+        jassertfalse;   // Allocation inside processBlock, see the call stack
+    }
+
+    // Upper edge of each bucket but the last, as a share of the block period
+    constexpr std::array<double, BlockTimingStats::numBuckets - 1> bucketEdges{
+        0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 1.0, 1.5
+    };
+}
+
+#if KGP_EQ_TRAP_AUDIO_THREAD_ALLOCATIONS
+namespace {
+    void* allocate(std::size_t size) {
+        trapAllocation();
+
+        if (auto* ptr = std::malloc(size == 0 ? 1 : size))
+            return ptr;
+
+        throw std::bad_alloc();
+    }
+}
+
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { try { return allocate(size); } catch (...) { return nullptr; } }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { try { return allocate(size); } catch (...) { return nullptr; } }
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+#endif
+
+bool AudioThreadGuard::isInAudioCallback() noexcept {
+    return audioCallbackDepth > 0;
+}
+
+juce::int64 AudioThreadGuard::getNumTrappedAllocations() noexcept {
+    return trappedAllocations.load(std::memory_order_relaxed);
+}
+
+//==============================================================================
+juce::String BlockTimingStats::getBucketName(int bucket) {
+    if (bucket == 0)
+        return "< " + juce::String(juce::roundToInt(bucketEdges[0] * 100.0)) + "%";
+
+    if (bucket == numBuckets - 1)
+        return ">= " + juce::String(juce::roundToInt(bucketEdges.back() * 100.0)) + "%";
+
+    return juce::String(juce::roundToInt(bucketEdges[(size_t)bucket - 1] * 100.0)) + "-"
+         + juce::String(juce::roundToInt(bucketEdges[(size_t)bucket] * 100.0)) + "%";
+}
+
+juce::String BlockTimingStats::toString() const {
+    juce::String text;
+
+    text << "Blocks: " << numBlocks << ", overruns: " << overruns << ", dropped records: " << droppedRecords << "\n";
+    text << "Mean load: " << juce::String(getMeanLoad() * 100.0, 1) << "%, worst load: "
+         << juce::String(worstLoad * 100.0, 1) << "% (" << juce::String(worstBlockMicroseconds, 1) << " us)\n";
+
+    text << "Block time / block period:\n";
+    for (int bucket = 0; bucket < numBuckets; ++bucket)
+        text << "  " << getBucketName(bucket).paddedRight(' ', 10) << buckets[(size_t)bucket] << "\n";
+
+   #if KGP_EQ_TRAP_AUDIO_THREAD_ALLOCATIONS
+    text << "Trapped allocations: " << AudioThreadGuard::getNumTrappedAllocations() << "\n";
+   #endif
+
+    return text;
+}
+
+//==============================================================================
+void AudioThreadMonitor::prepare(double newSampleRate) {
+    sampleRate.store(newSampleRate);
+}
+
+void AudioThreadMonitor::setEnabled(bool shouldBeEnabled) {
+    enabled.store(shouldBeEnabled, std::memory_order_relaxed);
+}
+
+BlockTimingStats AudioThreadMonitor::getStats() {
+    const auto ticksPerSecond = (double)juce::Time::getHighResolutionTicksPerSecond();
+    const auto rate = sampleRate.load();
+
+    auto read = fifo.read(fifo.getNumReady());
+
+    auto add = [&](int start, int size) {
+        for (int i = start; i < start + size; ++i) {
+            const auto& record = records[(size_t)i];
+
+            auto seconds = (double)record.ticks / ticksPerSecond;
+            auto load = seconds * rate / juce::jmax(1, record.numSamples);
+
+            auto bucket = (int)(std::upper_bound(bucketEdges.begin(), bucketEdges.end(), load) - bucketEdges.begin());
+            ++stats.buckets[(size_t)bucket];
+
+            ++stats.numBlocks;
+            stats.overruns += load > 1.0 ? 1 : 0;
+            stats.totalLoad += load;
+
+            if (load > stats.worstLoad) {
+                stats.worstLoad = load;
+                stats.worstBlockMicroseconds = seconds * 1.0e6;
+            }
+        }
+    };
+
+    add(read.startIndex1, read.blockSize1);
+    add(read.startIndex2, read.blockSize2);
+
+    stats.droppedRecords += droppedRecords.exchange(0);
+
+    return stats;
+}
+
+void AudioThreadMonitor::resetStats() {
+    fifo.read(fifo.getNumReady());
+    droppedRecords.store(0);
+
+    stats = {};
+}
+
+void AudioThreadMonitor::push(juce::int64 ticks, int numSamples) noexcept {
+    auto write = fifo.write(1);
+    if (write.blockSize1 > 0)
+        records[(size_t)write.startIndex1] = { ticks, numSamples };
+    else
+        droppedRecords.fetch_add(1, std::memory_order_relaxed);
+}
+
+//==============================================================================
+AudioThreadMonitor::ScopedBlock::ScopedBlock(AudioThreadMonitor& monitorToUse, int numSamplesInBlock) noexcept
+    : monitor(monitorToUse.isEnabled() ? &monitorToUse : nullptr), numSamples(numSamplesInBlock) {
+   #if KGP_EQ_TRAP_AUDIO_THREAD_ALLOCATIONS
+    ++audioCallbackDepth;
+   #endif
+
+    if (monitor != nullptr)
+        startTicks = juce::Time::getHighResolutionTicks();
+}
+
+AudioThreadMonitor::ScopedBlock::~ScopedBlock() noexcept {
+    if (monitor != nullptr)
+        monitor->push(juce::Time::getHighResolutionTicks() - startTicks, numSamples);
+
+   #if KGP_EQ_TRAP_AUDIO_THREAD_ALLOCATIONS
+    --audioCallbackDepth;
+   #endif
+}
@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+
+    AudioThreadMonitor.h
+
+    Instrumentation for processBlock. While block timing is enabled, the
+    audio thread writes the length of every block in high resolution ticks
+    into a single producer, single consumer FIFO, and the message thread
+    drains it into a histogram of block time over block period. While it is
+    disabled a block costs one relaxed atomic load.
+
+    Building with KGP_EQ_TRAP_AUDIO_THREAD_ALLOCATIONS=1 (debug builds only)
+    also replaces the global operator new, so an allocation inside
+    processBlock hits a jassert and is counted in the stats. Only allocations
+    are trapped; locks and other blocking calls are not. The replacement
+    applies to the whole binary, so leave it off in builds that are handed
+    to users.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+
+#ifndef KGP_EQ_TRAP_AUDIO_THREAD_ALLOCATIONS
+ #define KGP_EQ_TRAP_AUDIO_THREAD_ALLOCATIONS 0
+#endif
+
+#if KGP_EQ_TRAP_AUDIO_THREAD_ALLOCATIONS && ! JUCE_DEBUG
+ #error "KGP_EQ_TRAP_AUDIO_THREAD_ALLOCATIONS is meant for debug builds"
+#endif
+
+namespace AudioThreadGuard {
+    // True on a thread that is inside a monitored processBlock
+    bool isInAudioCallback() noexcept;
+
+    juce::int64 getNumTrappedAllocations() noexcept;
+}
+
+struct BlockTimingStats {
+    // Block time as a share of the block period: below 10%, 20% ... 100%, 150%, and above
+    static constexpr int numBuckets = 12;
+
+    static juce::String getBucketName(int bucket);
+
+    std::array<juce::int64, numBuckets> buckets{};
+
+    juce::int64 numBlocks{ 0 };
+    juce::int64 overruns{ 0 };          // Blocks that took longer than their period
+    juce::int64 droppedRecords{ 0 };    // Blocks that found the FIFO full
+
+    double totalLoad{ 0.0 };
+    double worstLoad{ 0.0 };
+    double worstBlockMicroseconds{ 0.0 };
+
+    double getMeanLoad() const { return numBlocks > 0 ? totalLoad / (double)numBlocks : 0.0; }
+
+    // Plain text report, meant for the clipboard
+    juce::String toString() const;
+};
+
+class AudioThreadMonitor {
+public:
+    void prepare(double sampleRate);
+
+    // Message thread
+    void setEnabled(bool shouldBeEnabled);
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    // Drains the FIFO into the running stats and returns them; message thread only
+    BlockTimingStats getStats();
+    void resetStats();
+
+    // Covers one processBlock call on the audio thread
+    class ScopedBlock {
+    public:
+        ScopedBlock(AudioThreadMonitor& monitorToUse, int numSamplesInBlock) noexcept;
+        ~ScopedBlock() noexcept;
+
+    private:
+        AudioThreadMonitor* monitor;
+        int numSamples;
+        juce::int64 startTicks{ 0 };
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedBlock)
+    };
+
+private:
+    struct BlockRecord {
+        juce::int64 ticks;
+        int numSamples;
+    };
+
+    // About a second of 16 sample blocks at 48 kHz, so a 4 Hz drain never falls behind
+    static constexpr int Capacity = 4096;
+
+    std::array<BlockRecord, Capacity> records;
+    juce::AbstractFifo fifo{ Capacity };
+
+    std::atomic<bool> enabled{ false };
+    std::atomic<double> sampleRate{ 44100.0 };
+    std::atomic<juce::int64> droppedRecords{ 0 };
+
+    // Consumer side
+    BlockTimingStats stats;
+
+    void push(juce::int64 ticks, int numSamples) noexcept;
+};
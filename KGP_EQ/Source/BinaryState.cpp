@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    BinaryState.cpp
+
+  ==============================================================================
+*/
+
+#include "BinaryState.h"
+
+namespace {
+    // Magic, version and parameter count
+    constexpr int headerSize = 3 * (int)sizeof(juce::int32);
+
+    juce::RangedAudioParameter* asRanged(juce::AudioProcessorParameter* parameter) {
+        auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter);
+        jassert(ranged != nullptr);   // Every APVTS parameter is ranged
+        return ranged;
+    }
+}
+
+void writeBinaryState(const juce::Array<juce::AudioProcessorParameter*>& parameters, juce::MemoryBlock& destData) {
+    juce::MemoryOutputStream stream(destData, false);
+
+    stream.writeInt((int)binaryStateMagic);
+    stream.writeInt(binaryStateVersion);
+    stream.writeInt(parameters.size());
+
+    for (auto* parameter : parameters) {
+        // Plain values survive a change of range or skew between versions
+        auto* ranged = asRanged(parameter);
+        stream.writeFloat(ranged != nullptr ? ranged->convertFrom0to1(ranged->getValue()) : parameter->getValue());
+    }
+}
+
+bool isBinaryState(const void* data, int sizeInBytes) {
+    if (data == nullptr || sizeInBytes < headerSize)
+        return false;
+
+    return (juce::uint32)juce::ByteOrder::littleEndianInt(data) == binaryStateMagic;
+}
+
+bool readBinaryState(const juce::Array<juce::AudioProcessorParameter*>& parameters, const void* data, int sizeInBytes) {
+    if (!isBinaryState(data, sizeInBytes))
+        return false;
+
+    juce::MemoryInputStream stream(data, (size_t)sizeInBytes, false);
+    stream.readInt();
+
+    auto version = stream.readInt();
+    auto numStored = stream.readInt();
+
+    if (version < 1 || version > binaryStateVersion || numStored < 0
+        || sizeInBytes < headerSize + numStored * (int)sizeof(float))
+        return false;
+
+    for (int i = 0; i < parameters.size(); ++i) {
+        auto* parameter = parameters[i];
+        auto* ranged = asRanged(parameter);
+
+        float normalised;
+        if (i < numStored) {
+            auto value = stream.readFloat();
+            normalised = ranged != nullptr ? ranged->convertTo0to1(value) : value;
+        }
+        else {
+            normalised = parameter->getDefaultValue();
+        }
+
+        if (normalised != parameter->getValue())
+            parameter->setValueNotifyingHost(normalised);
+    }
+
+    return true;
+}
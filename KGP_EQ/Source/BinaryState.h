@@ -0,0 +1,31 @@
+/*
+  ==============================================================================
+
+    BinaryState.h
+
+    Compact plugin state: a magic number, a format version and the plain
+    value of every parameter in getParameters() order. Parameters are only
+    ever appended to createParameterLayout(), so a state written by an
+    older build still lines up, and parameters it doesn't cover go back to
+    their defaults. Reordering or removing a parameter needs a new version.
+    Sessions saved before this format hold a ValueTree, which callers
+    recognise by isBinaryState() returning false.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+constexpr juce::uint32 binaryStateMagic = 0x4550474b;   // "KGPE" when written little endian
+constexpr int binaryStateVersion = 1;
+
+void writeBinaryState(const juce::Array<juce::AudioProcessorParameter*>& parameters, juce::MemoryBlock& destData);
+
+bool isBinaryState(const void* data, int sizeInBytes);
+
+// Only parameters whose value differs are set, so listeners hear about real changes only.
+// Returns false, without touching any parameter, if the data is truncated or from a newer,
+// incompatible version.
+bool readBinaryState(const juce::Array<juce::AudioProcessorParameter*>& parameters, const void* data, int sizeInBytes);
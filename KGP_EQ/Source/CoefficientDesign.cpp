@@ -0,0 +1,294 @@
+/*
+  ==============================================================================
+
+    CoefficientDesign.cpp
+
+  ==============================================================================
+*/
+
+#include "CoefficientDesign.h"
+
+namespace {
+    BiquadCoefficients normalise(double b0, double b1, double b2, double a0, double a1, double a2) {
+        auto a0Inv = 1.0 / a0;
+        return { b0 * a0Inv, b1 * a0Inv, b2 * a0Inv, a1 * a0Inv, a2 * a0Inv };
+    }
+
+    SvfCoefficients makeSvf(double g, double k, double m0, double m1, double m2) {
+        auto a1 = 1.0 / (1.0 + g * (g + k));
+        auto a2 = g * a1;
+        auto a3 = g * a2;
+
+        return { a1, a2, a3, m0, m1, m2 };
+    }
+
+    SvfCoefficients makeSvf(double sampleRate, double frequency, double k, double m0, double m1, double m2) {
+        return makeSvf(std::tan(juce::MathConstants<double>::pi * frequency / sampleRate), k, m0, m1, m2);
+    }
+
+    double getButterworthSectionQuality(int section, int order) {
+        return 1.0 / (2.0 * std::cos((2.0 * section + 1.0) * juce::MathConstants<double>::pi / (order * 2.0)));
+    }
+}
+
+BiquadCoefficients designPeakBiquad(double sampleRate, double frequency, double quality, double gainFactor) {
+    jassert(sampleRate > 0.0);
+    jassert(quality > 0.0);
+
+    auto A = juce::jmax(0.0, std::sqrt(gainFactor));
+    auto omega = (juce::MathConstants<double>::twoPi * juce::jmax(frequency, 2.0)) / sampleRate;
+    auto alpha = std::sin(omega) / (quality * 2.0);
+    auto c2 = -2.0 * std::cos(omega);
+    auto alphaTimesA = alpha * A;
+    auto alphaOverA = alpha / A;
+
+    return normalise(1.0 + alphaTimesA, c2, 1.0 - alphaTimesA,
+                     1.0 + alphaOverA, c2, 1.0 - alphaOverA);
+}
+
+BiquadCoefficients designLowPassBiquad(double sampleRate, double frequency, double quality) {
+    jassert(sampleRate > 0.0);
+    jassert(frequency > 0.0 && frequency <= sampleRate * 0.5);
+    jassert(quality > 0.0);
+
+    auto n = 1.0 / std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+    auto nSquared = n * n;
+    auto invQ = 1.0 / quality;
+    auto c1 = 1.0 / (1.0 + invQ * n + nSquared);
+
+    return { c1, c1 * 2.0, c1, c1 * 2.0 * (1.0 - nSquared), c1 * (1.0 - invQ * n + nSquared) };
+}
+
+BiquadCoefficients designHighPassBiquad(double sampleRate, double frequency, double quality) {
+    jassert(sampleRate > 0.0);
+    jassert(frequency > 0.0 && frequency <= sampleRate * 0.5);
+    jassert(quality > 0.0);
+
+    auto n = std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+    auto nSquared = n * n;
+    auto invQ = 1.0 / quality;
+    auto c1 = 1.0 / (1.0 + invQ * n + nSquared);
+
+    return { c1, c1 * -2.0, c1, c1 * 2.0 * (nSquared - 1.0), c1 * (1.0 - invQ * n + nSquared) };
+}
+
+BiquadCoefficients designLowShelfBiquad(double sampleRate, double frequency, double quality, double gainFactor) {
+    jassert(sampleRate > 0.0);
+    jassert(quality > 0.0);
+
+    auto A = juce::jmax(0.0, std::sqrt(gainFactor));
+    auto aMinus1 = A - 1.0;
+    auto aPlus1 = A + 1.0;
+    auto omega = (juce::MathConstants<double>::twoPi * juce::jmax(frequency, 2.0)) / sampleRate;
+    auto coso = std::cos(omega);
+    auto beta = std::sin(omega) * std::sqrt(A) / quality;
+    auto aMinus1TimesCoso = aMinus1 * coso;
+
+    return normalise(A * (aPlus1 - aMinus1TimesCoso + beta),
+                     A * 2.0 * (aMinus1 - aPlus1 * coso),
+                     A * (aPlus1 - aMinus1TimesCoso - beta),
+                     aPlus1 + aMinus1TimesCoso + beta,
+                     -2.0 * (aMinus1 + aPlus1 * coso),
+                     aPlus1 + aMinus1TimesCoso - beta);
+}
+
+BiquadCoefficients designHighShelfBiquad(double sampleRate, double frequency, double quality, double gainFactor) {
+    jassert(sampleRate > 0.0);
+    jassert(quality > 0.0);
+
+    auto A = juce::jmax(0.0, std::sqrt(gainFactor));
+    auto aMinus1 = A - 1.0;
+    auto aPlus1 = A + 1.0;
+    auto omega = (juce::MathConstants<double>::twoPi * juce::jmax(frequency, 2.0)) / sampleRate;
+    auto coso = std::cos(omega);
+    auto beta = std::sin(omega) * std::sqrt(A) / quality;
+    auto aMinus1TimesCoso = aMinus1 * coso;
+
+    return normalise(A * (aPlus1 + aMinus1TimesCoso + beta),
+                     A * -2.0 * (aMinus1 + aPlus1 * coso),
+                     A * (aPlus1 + aMinus1TimesCoso - beta),
+                     aPlus1 - aMinus1TimesCoso + beta,
+                     2.0 * (aMinus1 - aPlus1 * coso),
+                     aPlus1 - aMinus1TimesCoso - beta);
+}
+
+BiquadCoefficients designNotchBiquad(double sampleRate, double frequency, double quality) {
+    jassert(sampleRate > 0.0);
+    jassert(frequency > 0.0 && frequency <= sampleRate * 0.5);
+    jassert(quality > 0.0);
+
+    auto n = 1.0 / std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+    auto nSquared = n * n;
+    auto invQ = 1.0 / quality;
+    auto c1 = 1.0 / (1.0 + n * invQ + nSquared);
+    auto b0 = c1 * (1.0 + nSquared);
+    auto b1 = 2.0 * c1 * (1.0 - nSquared);
+
+    return { b0, b1, b0, b1, c1 * (1.0 - n * invQ + nSquared) };
+}
+
+SvfCoefficients designPeakSvf(double sampleRate, double frequency, double quality, double gainFactor) {
+    jassert(sampleRate > 0.0);
+    jassert(quality > 0.0);
+
+    auto A = juce::jmax(0.0, std::sqrt(gainFactor));
+    auto k = 1.0 / (quality * A);
+
+    return makeSvf(sampleRate, juce::jmax(frequency, 2.0), k, 1.0, k * (A * A - 1.0), 0.0);
+}
+
+SvfCoefficients designLowPassSvf(double sampleRate, double frequency, double quality) {
+    jassert(sampleRate > 0.0);
+    jassert(frequency > 0.0 && frequency <= sampleRate * 0.5);
+    jassert(quality > 0.0);
+
+    return makeSvf(sampleRate, frequency, 1.0 / quality, 0.0, 0.0, 1.0);
+}
+
+SvfCoefficients designHighPassSvf(double sampleRate, double frequency, double quality) {
+    jassert(sampleRate > 0.0);
+    jassert(frequency > 0.0 && frequency <= sampleRate * 0.5);
+    jassert(quality > 0.0);
+
+    auto k = 1.0 / quality;
+    return makeSvf(sampleRate, frequency, k, 1.0, -k, -1.0);
+}
+
+CascadeCoefficients designPeak(double sampleRate, double frequency, double quality, double gainFactor) {
+    CascadeCoefficients peak;
+    peak.numStages = 1;
+    peak.stages[0] = designPeakBiquad(sampleRate, frequency, quality, gainFactor);
+    peak.svfStages[0] = designPeakSvf(sampleRate, frequency, quality, gainFactor);
+
+    return peak;
+}
+
+BiquadCoefficients designMatchedPeakBiquad(double sampleRate, double frequency, double quality, double gainFactor) {
+    jassert(sampleRate > 0.0);
+    jassert(quality > 0.0);
+
+    // M. Vicanek, "Matched Second Order Digital Filters" (2016). The poles are placed by
+    // impulse invariance; the zeros match the analog magnitude at DC and at the centre.
+    auto G = juce::jmax(1.0e-6, gainFactor);
+    auto omega = juce::MathConstants<double>::twoPi * juce::jlimit(2.0, sampleRate * 0.4999, frequency) / sampleRate;
+
+    auto zeta = 1.0 / (2.0 * quality * std::sqrt(G));
+    auto decay = std::exp(-zeta * omega);
+
+    auto a1 = zeta <= 1.0 ? -2.0 * decay * std::cos(std::sqrt(1.0 - zeta * zeta) * omega)
+                          : -2.0 * decay * std::cosh(std::sqrt(zeta * zeta - 1.0) * omega);
+    auto a2 = decay * decay;
+
+    auto A0 = (1.0 + a1 + a2) * (1.0 + a1 + a2);
+    auto A1 = (1.0 - a1 + a2) * (1.0 - a1 + a2);
+    auto A2 = -4.0 * a2;
+
+    // |H|^2 = (B0 phi0 + B1 phi1 + B2 phi2) / (A0 phi0 + A1 phi1 + A2 phi2), phi1 = sin^2(w / 2)
+    auto phi1 = std::sin(omega * 0.5) * std::sin(omega * 0.5);
+    auto phi0 = 1.0 - phi1;
+    auto phi2 = 4.0 * phi0 * phi1;
+
+    // Power at the centre is G^2 times the pole part, and so is its derivative in phi1
+    auto R1 = (A0 * phi0 + A1 * phi1 + A2 * phi2) * G * G;
+    auto R2 = (-A0 + A1 + 4.0 * (phi0 - phi1) * A2) * G * G;
+
+    auto B0 = A0;
+    auto B2 = (R1 - R2 * phi1 - B0) / (4.0 * phi1 * phi1);
+    auto B1 = R2 + B0 + 4.0 * (phi1 - phi0) * B2;
+
+    auto W = 0.5 * (std::sqrt(B0) + std::sqrt(juce::jmax(0.0, B1)));
+    auto b0 = 0.5 * (W + std::sqrt(juce::jmax(0.0, W * W + B2)));
+    auto b1 = 0.5 * (std::sqrt(B0) - std::sqrt(juce::jmax(0.0, B1)));
+    auto b2 = -B2 / (4.0 * b0);
+
+    return { b0, b1, b2, a1, a2 };
+}
+
+SvfCoefficients convertToSvf(const BiquadCoefficients& c) {
+    // Every stable pole pair is the bilinear image of some analog pair, so solve for the
+    // prewarped g and damping k, then for the analog numerator n2 s^2 + n1 s + n0
+    auto sumAtDC = 1.0 + c.a1 + c.a2;
+    auto sumAtNyquist = 1.0 - c.a1 + c.a2;
+    jassert(sumAtDC > 0.0 && sumAtNyquist > 0.0);
+
+    auto g = std::sqrt(sumAtDC / sumAtNyquist);
+    auto k = 2.0 * (1.0 - c.a2) / (sumAtNyquist * g);
+    auto denominator = 4.0 / sumAtNyquist;
+
+    auto n0 = (c.b0 + c.b1 + c.b2) * denominator / (4.0 * g * g);
+    auto n1 = (c.b0 - c.b2) * denominator / (2.0 * g);
+    auto n2 = (c.b0 - c.b1 + c.b2) * denominator / 4.0;
+
+    return makeSvf(g, k, n2, n1 - n2 * k, n0 - n2);
+}
+
+CascadeCoefficients designMatchedPeak(double sampleRate, double frequency, double quality, double gainFactor) {
+    CascadeCoefficients peak;
+    peak.numStages = 1;
+    peak.stages[0] = designMatchedPeakBiquad(sampleRate, frequency, quality, gainFactor);
+    peak.svfStages[0] = convertToSvf(peak.stages[0]);
+
+    return peak;
+}
+
+CascadeCoefficients designButterworthHighPass(double sampleRate, double frequency, int order) {
+    jassert(order > 0 && order % 2 == 0 && order / 2 <= CascadeCoefficients::maxStages);
+
+    CascadeCoefficients cut;
+    cut.numStages = order / 2;
+
+    for (int i = 0; i < cut.numStages; i++) {
+        auto quality = getButterworthSectionQuality(i, order);
+        cut.stages[i] = designHighPassBiquad(sampleRate, frequency, quality);
+        cut.svfStages[i] = designHighPassSvf(sampleRate, frequency, quality);
+    }
+
+    return cut;
+}
+
+CascadeCoefficients designButterworthLowPass(double sampleRate, double frequency, int order) {
+    jassert(order > 0 && order % 2 == 0 && order / 2 <= CascadeCoefficients::maxStages);
+
+    CascadeCoefficients cut;
+    cut.numStages = order / 2;
+
+    for (int i = 0; i < cut.numStages; i++) {
+        auto quality = getButterworthSectionQuality(i, order);
+        cut.stages[i] = designLowPassBiquad(sampleRate, frequency, quality);
+        cut.svfStages[i] = designLowPassSvf(sampleRate, frequency, quality);
+    }
+
+    return cut;
+}
+
+double getPoleRadius(const BiquadCoefficients& coefficients) {
+    // Roots of z^2 + a1 z + a2
+    auto discriminant = coefficients.a1 * coefficients.a1 - 4.0 * coefficients.a2;
+
+    if (discriminant < 0.0)
+        return std::sqrt(coefficients.a2);
+
+    auto root = std::sqrt(discriminant);
+    return juce::jmax(std::abs(-coefficients.a1 + root), std::abs(-coefficients.a1 - root)) * 0.5;
+}
+
+int getTailLengthInSamples(const CascadeCoefficients& coefficients) {
+    return getTailLengthInSamples(coefficients.stages.data(), coefficients.numStages);
+}
+
+int getTailLengthInSamples(const BiquadCoefficients* sections, int numSections) {
+    const auto logAttenuation = std::log(1.0e-6);
+
+    // Each section rings on the output of the previous one, so the tails add up
+    double tailLength = 0.0;
+    for (int i = 0; i < numSections; i++) {
+        auto radius = getPoleRadius(sections[i]);
+
+        if (radius >= 1.0)
+            return maxTailLength;
+
+        tailLength += radius > 0.0 ? logAttenuation / std::log(radius) + 2.0 : 2.0;
+    }
+
+    return (int)juce::jmin((double)maxTailLength, std::ceil(tailLength));
+}
@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    CoefficientDesign.h
+
+    Allocation-free filter designs producing plain coefficient structs, so
+    they can be computed on any thread and handed to the audio thread
+    without touching reference counted juce::dsp::IIR::Coefficients.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+enum FilterTopology {
+    tdf2Float,
+    tdf2Double,
+    svfDouble
+};
+
+struct BiquadCoefficients {
+    // Normalised so that a0 == 1, same order as juce::dsp::IIR::Coefficients stores them
+    double b0{ 1.0 }, b1{ 0.0 }, b2{ 0.0 }, a1{ 0.0 }, a2{ 0.0 };
+};
+
+struct SvfCoefficients {
+    // Trapezoidal state variable filter (A. Simper), output = m0 * in + m1 * band + m2 * low
+    double a1{ 1.0 }, a2{ 0.0 }, a3{ 0.0 };
+    double m0{ 1.0 }, m1{ 0.0 }, m2{ 0.0 };
+};
+
+// The same response expressed for both topologies, so the engine can switch per band
+struct CascadeCoefficients {
+    static constexpr int maxStages = 4;
+
+    std::array<BiquadCoefficients, maxStages> stages;
+    std::array<SvfCoefficients, maxStages> svfStages;
+    int numStages{ 1 };
+};
+
+constexpr int maxParametricBands = 16;
+
+// One section per parametric band that isn't bypassed, packed at the front in band order
+struct ParametricBandCoefficients {
+    std::array<BiquadCoefficients, maxParametricBands> sections;
+    std::array<int, maxParametricBands> bandIndices{};
+    int numActive{ 0 };
+};
+
+BiquadCoefficients designPeakBiquad(double sampleRate, double frequency, double quality, double gainFactor);
+BiquadCoefficients designLowPassBiquad(double sampleRate, double frequency, double quality);
+BiquadCoefficients designHighPassBiquad(double sampleRate, double frequency, double quality);
+BiquadCoefficients designLowShelfBiquad(double sampleRate, double frequency, double quality, double gainFactor);
+BiquadCoefficients designHighShelfBiquad(double sampleRate, double frequency, double quality, double gainFactor);
+BiquadCoefficients designNotchBiquad(double sampleRate, double frequency, double quality);
+
+SvfCoefficients designPeakSvf(double sampleRate, double frequency, double quality, double gainFactor);
+SvfCoefficients designLowPassSvf(double sampleRate, double frequency, double quality);
+SvfCoefficients designHighPassSvf(double sampleRate, double frequency, double quality);
+
+CascadeCoefficients designPeak(double sampleRate, double frequency, double quality, double gainFactor);
+
+// Peak whose magnitude follows the analog prototype up to Nyquist instead of cramping
+// towards it like the bilinear design does, at the same cost per sample
+BiquadCoefficients designMatchedPeakBiquad(double sampleRate, double frequency, double quality, double gainFactor);
+CascadeCoefficients designMatchedPeak(double sampleRate, double frequency, double quality, double gainFactor);
+
+// SVF with the same transfer function as a stable biquad
+SvfCoefficients convertToSvf(const BiquadCoefficients& coefficients);
+
+// Same section layout as juce::dsp::FilterDesign's HighOrderButterworthMethod for even orders
+CascadeCoefficients designButterworthHighPass(double sampleRate, double frequency, int order);
+CascadeCoefficients designButterworthLowPass(double sampleRate, double frequency, int order);
+
+// Largest pole magnitude of the section; 1 or more means it never decays
+double getPoleRadius(const BiquadCoefficients& coefficients);
+
+// Samples until the impulse response of the cascade has decayed by 120 dB, capped at maxTailLength
+int getTailLengthInSamples(const CascadeCoefficients& coefficients);
+int getTailLengthInSamples(const BiquadCoefficients* sections, int numSections);
+constexpr int maxTailLength = 1 << 22;
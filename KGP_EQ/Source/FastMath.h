@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    FastMath.h
+
+    Branch-free approximations used by the analyzer and response curve, written
+    so that loops calling them auto-vectorise.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <cfloat>
+#include <cstring>
+
+// log2 for positive, normal x. The mantissa is folded into [sqrt(0.5), sqrt(2)) and
+// fed to a three term atanh series; the absolute error is below 2e-6.
+inline float fastLog2(float x) {
+    juce::uint32 bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+
+    // Folding is decided on the raw mantissa bits (sqrt(2) is 0x3fb504f3), because integer
+    // selects vectorise even where floating point comparisons are treated as trapping
+    const auto mantissaBits = bits & 0x007fffffu;
+    const auto fold = mantissaBits > 0x003504f3u ? 1u : 0u;
+
+    const auto exponent = (float)((int)((bits >> 23) & 0xff) - 127 + (int)fold);
+    bits = mantissaBits | (0x3f800000u - (fold << 23));
+
+    float mantissa;
+    std::memcpy(&mantissa, &bits, sizeof(mantissa));
+
+    const auto t = (mantissa - 1.f) / (mantissa + 1.f);
+    const auto t2 = t * t;
+
+    constexpr float c1 = 2.8853900818f;   // 2 / ln 2
+    constexpr float c3 = 0.9617966939f;   // 2 / (3 ln 2)
+    constexpr float c5 = 0.5770780164f;   // 2 / (5 ln 2)
+
+    return exponent + t * (c1 + t2 * (c3 + t2 * c5));
+}
+
+inline float fastGainToDecibels(float gain) {
+    constexpr float decibelsPerOctave = 6.0205999133f;   // 20 * log10(2)
+    return fastLog2(gain) * decibelsPerOctave;
+}
+
+inline float fastPowerToDecibels(float power) {
+    constexpr float decibelsPerOctave = 3.0102999566f;   // 10 * log10(2)
+    return fastLog2(power) * decibelsPerOctave;
+}
+
+// max(x, minimum) for a positive minimum. Positive floats order like their bit patterns and
+// negative ones compare below any positive int, so this is an integer max that vectorises.
+inline float clampToPositiveMinimum(float x, float minimum) {
+    juce::int32 bits, minimumBits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    std::memcpy(&minimumBits, &minimum, sizeof(minimumBits));
+    bits = bits > minimumBits ? bits : minimumBits;
+
+    float clamped;
+    std::memcpy(&clamped, &bits, sizeof(clamped));
+    return clamped;
+}
+
+// In place: NaN and Inf become silence, everything is multiplied by scale, then
+// converted to decibels and clamped at negativeInfinity, all in one pass.
+inline void magnitudesToDecibels(float* data, int numValues, float scale, float negativeInfinity) {
+    const auto minimumGain = juce::Decibels::decibelsToGain(negativeInfinity, negativeInfinity - 1.f);
+
+    for (int i = 0; i < numValues; i++) {
+        juce::uint32 bits;
+        std::memcpy(&bits, data + i, sizeof(bits));
+
+        // An all-ones exponent field means NaN or Inf
+        const auto finiteMask = (bits & 0x7f800000u) != 0x7f800000u ? 0xffffffffu : 0u;
+        bits &= finiteMask;
+
+        float v;
+        std::memcpy(&v, &bits, sizeof(v));
+
+        data[i] = fastGainToDecibels(clampToPositiveMinimum(v * scale, minimumGain));
+    }
+}
@@ -0,0 +1,352 @@
+/*
+  ==============================================================================
+
+    FilterEngine.cpp
+
+  ==============================================================================
+*/
+
+#include "FilterEngine.h"
+
+namespace {
+    template<int Index, int NumStages, typename StageType, typename StateType, typename Register>
+    Register processStages(Register x, const StageType* stages, StateType* state) {
+        auto y = stages[Index].process(x, state[Index]);
+
+        if constexpr (Index + 1 < NumStages)
+            return processStages<Index + 1, NumStages>(y, stages, state);
+        else
+            return y;
+    }
+
+    template<int NumStages, typename StageType, typename StateType, typename Register>
+    void processCascade(Register* data, int numSamples, const StageType* stages, StateType* state) {
+        // Coefficients and state are copied into locals so the unrolled cascade can live in registers
+        std::array<StageType, NumStages> c;
+        std::array<StateType, NumStages> s;
+
+        for (int i = 0; i < NumStages; i++) {
+            c[i] = stages[i];
+            s[i] = state[i];
+        }
+
+        for (int i = 0; i < numSamples; i++)
+            data[i] = processStages<0, NumStages>(data[i], c.data(), s.data());
+
+        for (int i = 0; i < NumStages; i++)
+            state[i] = s[i];
+    }
+
+    // Dispatches once per block to a cascade kernel specialised for the band's stage count
+    template<typename StageType, typename StateType, typename Register>
+    void processCascade(int numStages, Register* data, int numSamples, const StageType* stages, StateType* state) {
+        switch (numStages) {
+        case 1:
+            processCascade<1>(data, numSamples, stages, state);
+            break;
+        case 2:
+            processCascade<2>(data, numSamples, stages, state);
+            break;
+        case 3:
+            processCascade<3>(data, numSamples, stages, state);
+            break;
+        case 4:
+            processCascade<4>(data, numSamples, stages, state);
+            break;
+        default:
+            jassertfalse;
+            break;
+        }
+    }
+}
+
+template<typename SampleType>
+void LaneBuffer<SampleType>::prepare(int newNumChannels, int maximumBlockSize) {
+    numChannels = newNumChannels;
+    numGroups = (numChannels + Traits::numLanes - 1) / Traits::numLanes;
+    maxBlockSize = maximumBlockSize;
+
+    data.resize((size_t)(numGroups * maxBlockSize));
+}
+
+template<typename SampleType>
+void LaneBuffer<SampleType>::interleave(const juce::dsp::AudioBlock<float>& block, int startSample, int numSamples) {
+    const auto blockChannels = juce::jmin((int)block.getNumChannels(), numChannels);
+
+    for (int group = 0; group < numGroups; group++) {
+        auto* lanes = getGroup(group);
+
+        for (int i = 0; i < numSamples; i++)
+            lanes[i] = Traits::broadcast(0);
+
+        for (int lane = 0; lane < Traits::numLanes; lane++) {
+            auto channel = group * Traits::numLanes + lane;
+            if (channel >= blockChannels)
+                break;
+
+            auto* source = block.getChannelPointer((size_t)channel) + startSample;
+            for (int i = 0; i < numSamples; i++)
+                Traits::setLane(lanes[i], lane, (SampleType)source[i]);
+        }
+    }
+}
+
+template<typename SampleType>
+void LaneBuffer<SampleType>::deinterleave(juce::dsp::AudioBlock<float>& block, int startSample, int numSamples) const {
+    const auto blockChannels = juce::jmin((int)block.getNumChannels(), numChannels);
+
+    for (int channel = 0; channel < blockChannels; channel++) {
+        auto* lanes = data.data() + (channel / Traits::numLanes) * maxBlockSize;
+        auto lane = channel % Traits::numLanes;
+
+        auto* destination = block.getChannelPointer((size_t)channel) + startSample;
+        for (int i = 0; i < numSamples; i++)
+            destination[i] = (float)Traits::getLane(lanes[i], lane);
+    }
+}
+
+template struct LaneBuffer<float>;
+template struct LaneBuffer<double>;
+
+void FilterEngine::prepare(int numChannels, int maximumBlockSize) {
+    maxBlockSize = juce::jmax(1, maximumBlockSize);
+
+    floatLanes.prepare(numChannels, maxBlockSize);
+    doubleLanes.prepare(numChannels, maxBlockSize);
+
+    for (auto& band : bands) {
+        band.floatState.resize((size_t)(floatLanes.numGroups * maxStages));
+        band.doubleState.resize((size_t)(doubleLanes.numGroups * maxStages));
+    }
+
+    parametricBank.s1.resize((size_t)(floatLanes.numGroups * maxParametricBands));
+    parametricBank.s2.resize((size_t)(floatLanes.numGroups * maxParametricBands));
+
+    reset();
+}
+
+void FilterEngine::reset() {
+    for (auto& band : bands)
+        resetBand(band);
+
+    std::fill(parametricBank.s1.begin(), parametricBank.s1.end(), LaneTraits<float>::broadcast(0.f));
+    std::fill(parametricBank.s2.begin(), parametricBank.s2.end(), LaneTraits<float>::broadcast(0.f));
+}
+
+void FilterEngine::resetParametricBand(int bandIndex) {
+    for (int group = 0; group < floatLanes.numGroups; group++) {
+        parametricBank.s1[(size_t)(group * maxParametricBands + bandIndex)] = LaneTraits<float>::broadcast(0.f);
+        parametricBank.s2[(size_t)(group * maxParametricBands + bandIndex)] = LaneTraits<float>::broadcast(0.f);
+    }
+}
+
+void FilterEngine::resetBand(Band& band) {
+    for (auto& state : band.floatState) {
+        state.s1 = LaneTraits<float>::broadcast(0.f);
+        state.s2 = LaneTraits<float>::broadcast(0.f);
+    }
+
+    for (auto& state : band.doubleState) {
+        state.s1 = LaneTraits<double>::broadcast(0.0);
+        state.s2 = LaneTraits<double>::broadcast(0.0);
+    }
+}
+
+void FilterEngine::resetStages(Band& band, int firstStage) {
+    for (int group = 0; group < floatLanes.numGroups; group++) {
+        for (int stage = firstStage; stage < maxStages; stage++) {
+            auto& state = band.floatState[(size_t)(group * maxStages + stage)];
+            state.s1 = LaneTraits<float>::broadcast(0.f);
+            state.s2 = LaneTraits<float>::broadcast(0.f);
+        }
+    }
+
+    for (int group = 0; group < doubleLanes.numGroups; group++) {
+        for (int stage = firstStage; stage < maxStages; stage++) {
+            auto& state = band.doubleState[(size_t)(group * maxStages + stage)];
+            state.s1 = LaneTraits<double>::broadcast(0.0);
+            state.s2 = LaneTraits<double>::broadcast(0.0);
+        }
+    }
+}
+
+void FilterEngine::setLowCut(const CascadeCoefficients& coefficients, FilterTopology topology, bool bypassed) {
+    setBand(bands[lowCutBand], coefficients, topology, bypassed);
+}
+
+void FilterEngine::setPeak(const CascadeCoefficients& coefficients, FilterTopology topology, bool bypassed) {
+    setBand(bands[peakBand], coefficients, topology, bypassed);
+}
+
+void FilterEngine::setHighCut(const CascadeCoefficients& coefficients, FilterTopology topology, bool bypassed) {
+    setBand(bands[highCutBand], coefficients, topology, bypassed);
+}
+
+void FilterEngine::setBand(Band& band, const CascadeCoefficients& coefficients, FilterTopology topology, bool bypassed) {
+    jassert(coefficients.numStages > 0 && coefficients.numStages <= maxStages);
+
+    // The state of one topology means nothing to another, and a band coming out of bypass
+    // holds whatever it had when it was last processed, so both start from silence.
+    // Stages added by a steeper slope are just as stale, so they start from silence too.
+    if (topology != band.topology || (band.bypassed && !bypassed))
+        resetBand(band);
+    else if (coefficients.numStages > band.numStages)
+        resetStages(band, band.numStages);
+
+    for (int i = 0; i < coefficients.numStages; i++) {
+        switch (topology) {
+        case FilterTopology::tdf2Float:
+            band.floatStages[i].set(coefficients.stages[i]);
+            break;
+        case FilterTopology::tdf2Double:
+            band.doubleStages[i].set(coefficients.stages[i]);
+            break;
+        case FilterTopology::svfDouble:
+            band.svfStages[i].set(coefficients.svfStages[i]);
+            break;
+        }
+    }
+
+    band.topology = topology;
+    band.numStages = coefficients.numStages;
+    band.tailLength = ::getTailLengthInSamples(coefficients);
+    band.bypassed = bypassed;
+}
+
+void FilterEngine::setParametricBands(const ParametricBandCoefficients& coefficients) {
+    auto& bank = parametricBank;
+    jassert(juce::isPositiveAndNotGreaterThan(coefficients.numActive, maxParametricBands));
+
+    // A band that wasn't running has stale state from whenever it last ran
+    std::array<bool, maxParametricBands> wasActive{};
+    for (int i = 0; i < bank.numActive; i++)
+        wasActive[(size_t)bank.bandIndices[i]] = true;
+
+    for (int i = 0; i < coefficients.numActive; i++) {
+        auto bandIndex = coefficients.bandIndices[i];
+        if (!wasActive[(size_t)bandIndex])
+            resetParametricBand(bandIndex);
+
+        const auto& c = coefficients.sections[i];
+        bank.bandIndices[i] = bandIndex;
+        bank.b0[i] = LaneTraits<float>::broadcast((float)c.b0);
+        bank.b1[i] = LaneTraits<float>::broadcast((float)c.b1);
+        bank.b2[i] = LaneTraits<float>::broadcast((float)c.b2);
+        bank.a1[i] = LaneTraits<float>::broadcast((float)c.a1);
+        bank.a2[i] = LaneTraits<float>::broadcast((float)c.a2);
+    }
+
+    bank.numActive = coefficients.numActive;
+    bank.tailLength = ::getTailLengthInSamples(coefficients.sections.data(), coefficients.numActive);
+}
+
+int FilterEngine::getTailLengthInSamples() const {
+    int tailLength = 0;
+    for (auto& band : bands) {
+        if (!band.bypassed)
+            tailLength = juce::jmin(maxTailLength, tailLength + band.tailLength);
+    }
+
+    return juce::jmin(maxTailLength, tailLength + parametricBank.tailLength);
+}
+
+void FilterEngine::process(juce::dsp::AudioBlock<float>& block) {
+    jassert((int)block.getNumChannels() <= floatLanes.numChannels);
+
+    const auto totalNumSamples = (int)block.getNumSamples();
+
+    // Hosts occasionally exceed the block size they announced, so work in chunks
+    for (int start = 0; start < totalNumSamples; start += maxBlockSize) {
+        const auto numSamples = juce::jmin(maxBlockSize, totalNumSamples - start);
+
+        // Consecutive bands of the same precision share one pass through the lane buffer
+        enum Packing { packedNone, packedFloat, packedDouble } packed = packedNone;
+
+        auto pack = [&](Packing needed) {
+            if (needed == packed)
+                return;
+
+            if (packed == packedFloat)
+                floatLanes.deinterleave(block, start, numSamples);
+            else if (packed == packedDouble)
+                doubleLanes.deinterleave(block, start, numSamples);
+
+            if (needed == packedFloat)
+                floatLanes.interleave(block, start, numSamples);
+            else
+                doubleLanes.interleave(block, start, numSamples);
+
+            packed = needed;
+        };
+
+        for (int index = 0; index < numBands; index++) {
+            auto& band = bands[(size_t)index];
+
+            if (!band.bypassed) {
+                pack(band.usesDoublePrecision() ? packedDouble : packedFloat);
+
+                if (packed == packedFloat)
+                    processBand(band, floatLanes, numSamples);
+                else
+                    processBand(band, doubleLanes, numSamples);
+            }
+
+            if (index == peakBand && parametricBank.numActive > 0) {
+                pack(packedFloat);
+                processParametricBank(parametricBank, floatLanes, numSamples);
+            }
+        }
+
+        if (packed == packedFloat)
+            floatLanes.deinterleave(block, start, numSamples);
+        else if (packed == packedDouble)
+            doubleLanes.deinterleave(block, start, numSamples);
+    }
+}
+
+void FilterEngine::processBand(Band& band, LaneBuffer<float>& lanes, int numSamples) {
+    for (int group = 0; group < lanes.numGroups; group++) {
+        processCascade(band.numStages, lanes.getGroup(group), numSamples,
+                       band.floatStages.data(), band.floatState.data() + group * maxStages);
+    }
+}
+
+void FilterEngine::processParametricBank(ParametricBank& bank, LaneBuffer<float>& lanes, int numSamples) {
+    for (int group = 0; group < lanes.numGroups; group++) {
+        auto* data = lanes.getGroup(group);
+        auto* s1 = bank.s1.data() + group * maxParametricBands;
+        auto* s2 = bank.s2.data() + group * maxParametricBands;
+
+        for (int i = 0; i < bank.numActive; i++) {
+            const auto b0 = bank.b0[i], b1 = bank.b1[i], b2 = bank.b2[i];
+            const auto a1 = bank.a1[i], a2 = bank.a2[i];
+
+            auto bandIndex = bank.bandIndices[i];
+            auto z1 = s1[bandIndex];
+            auto z2 = s2[bandIndex];
+
+            // Transposed direct form II, as in TdfStage
+            for (int n = 0; n < numSamples; n++) {
+                auto x = data[n];
+                auto y = x * b0 + z1;
+                z1 = x * b1 - y * a1 + z2;
+                z2 = x * b2 - y * a2;
+                data[n] = y;
+            }
+
+            s1[bandIndex] = z1;
+            s2[bandIndex] = z2;
+        }
+    }
+}
+
+void FilterEngine::processBand(Band& band, LaneBuffer<double>& lanes, int numSamples) {
+    for (int group = 0; group < lanes.numGroups; group++) {
+        auto* state = band.doubleState.data() + group * maxStages;
+
+        if (band.topology == FilterTopology::svfDouble)
+            processCascade(band.numStages, lanes.getGroup(group), numSamples, band.svfStages.data(), state);
+        else
+            processCascade(band.numStages, lanes.getGroup(group), numSamples, band.doubleStages.data(), state);
+    }
+}
@@ -0,0 +1,185 @@
+/*
+  ==============================================================================
+
+    FilterEngine.h
+
+    Cascaded biquad engine that runs every channel through one shared set of
+    coefficients. Channels are packed into the lanes of a SIMD register, so a
+    stereo block is filtered by a single pass over each stage.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+#include "CoefficientDesign.h"
+
+template<typename SampleType>
+struct LaneTraits {
+   #if JUCE_USE_SIMD
+    using Register = juce::dsp::SIMDRegister<SampleType>;
+    static constexpr int numLanes = (int)Register::SIMDNumElements;
+
+    static Register broadcast(SampleType value) { return Register::expand(value); }
+    static void setLane(Register& r, int lane, SampleType value) { r.set((size_t)lane, value); }
+    static SampleType getLane(const Register& r, int lane) { return r.get((size_t)lane); }
+   #else
+    using Register = SampleType;
+    static constexpr int numLanes = 1;
+
+    static Register broadcast(SampleType value) { return value; }
+    static void setLane(Register& r, int, SampleType value) { r = value; }
+    static SampleType getLane(const Register& r, int) { return r; }
+   #endif
+};
+
+template<typename SampleType>
+struct StageState {
+    using Register = typename LaneTraits<SampleType>::Register;
+
+    Register s1, s2;
+};
+
+template<typename SampleType>
+struct TdfStage {
+    using Traits = LaneTraits<SampleType>;
+    using Register = typename Traits::Register;
+
+    Register b0, b1, b2, a1, a2;
+
+    void set(const BiquadCoefficients& c) {
+        b0 = Traits::broadcast((SampleType)c.b0);
+        b1 = Traits::broadcast((SampleType)c.b1);
+        b2 = Traits::broadcast((SampleType)c.b2);
+        a1 = Traits::broadcast((SampleType)c.a1);
+        a2 = Traits::broadcast((SampleType)c.a2);
+    }
+
+    // Transposed direct form II
+    Register process(Register x, StageState<SampleType>& state) const {
+        auto y = x * b0 + state.s1;
+        state.s1 = x * b1 - y * a1 + state.s2;
+        state.s2 = x * b2 - y * a2;
+        return y;
+    }
+};
+
+template<typename SampleType>
+struct SvfStage {
+    using Traits = LaneTraits<SampleType>;
+    using Register = typename Traits::Register;
+
+    Register a1, a2, a3, m0, m1, m2;
+
+    void set(const SvfCoefficients& c) {
+        a1 = Traits::broadcast((SampleType)c.a1);
+        a2 = Traits::broadcast((SampleType)c.a2);
+        a3 = Traits::broadcast((SampleType)c.a3);
+        m0 = Traits::broadcast((SampleType)c.m0);
+        m1 = Traits::broadcast((SampleType)c.m1);
+        m2 = Traits::broadcast((SampleType)c.m2);
+    }
+
+    // s1 and s2 hold the ic1eq/ic2eq integrator states
+    Register process(Register v0, StageState<SampleType>& state) const {
+        auto v3 = v0 - state.s2;
+        auto v1 = state.s1 * a1 + v3 * a2;
+        auto v2 = state.s2 + state.s1 * a2 + v3 * a3;
+        state.s1 = v1 + v1 - state.s1;
+        state.s2 = v2 + v2 - state.s2;
+        return v0 * m0 + v1 * m1 + v2 * m2;
+    }
+};
+
+// Channel samples packed lane-wise, indexed [group * maxBlockSize + sample]
+template<typename SampleType>
+struct LaneBuffer {
+    using Traits = LaneTraits<SampleType>;
+    using Register = typename Traits::Register;
+
+    void prepare(int numChannels, int maximumBlockSize);
+
+    void interleave(const juce::dsp::AudioBlock<float>& block, int startSample, int numSamples);
+    void deinterleave(juce::dsp::AudioBlock<float>& block, int startSample, int numSamples) const;
+
+    Register* getGroup(int group) { return data.data() + group * maxBlockSize; }
+
+    int numChannels{ 0 }, numGroups{ 0 }, maxBlockSize{ 0 };
+    std::vector<Register> data;
+};
+
+class FilterEngine {
+public:
+    void prepare(int numChannels, int maximumBlockSize);
+    void reset();
+
+    void setLowCut(const CascadeCoefficients& coefficients, FilterTopology topology, bool bypassed);
+    void setPeak(const CascadeCoefficients& coefficients, FilterTopology topology, bool bypassed);
+    void setHighCut(const CascadeCoefficients& coefficients, FilterTopology topology, bool bypassed);
+
+    // Always float TDF-II; runs between the peak and the high cut
+    void setParametricBands(const ParametricBandCoefficients& coefficients);
+
+    void process(juce::dsp::AudioBlock<float>& block);
+
+    // Ring out time of the active bands, recomputed whenever a band is set
+    int getTailLengthInSamples() const;
+
+private:
+    static constexpr int maxStages = CascadeCoefficients::maxStages;
+
+    struct Band {
+        FilterTopology topology{ FilterTopology::tdf2Float };
+        int numStages{ 0 };
+        int tailLength{ 0 };
+        bool bypassed{ true };
+
+        std::array<TdfStage<float>, maxStages> floatStages;
+        std::array<TdfStage<double>, maxStages> doubleStages;
+        std::array<SvfStage<double>, maxStages> svfStages;
+
+        // maxStages entries per lane group; the double state is shared by both double topologies
+        std::vector<StageState<float>> floatState;
+        std::vector<StageState<double>> doubleState;
+
+        bool usesDoublePrecision() const { return topology != FilterTopology::tdf2Float; }
+    };
+
+    enum { lowCutBand, peakBand, highCutBand, numBands };
+    std::array<Band, numBands> bands;
+
+    // Structure of arrays over the active sections only, so one tight loop per section
+    // runs over the block. The state is indexed by band, so enabling or disabling one
+    // band leaves the others ringing undisturbed.
+    struct ParametricBank {
+        using Register = LaneTraits<float>::Register;
+
+        int numActive{ 0 };
+        int tailLength{ 0 };
+        std::array<int, maxParametricBands> bandIndices{};
+        std::array<Register, maxParametricBands> b0, b1, b2, a1, a2;
+
+        // maxParametricBands entries per lane group
+        std::vector<Register> s1, s2;
+    };
+
+    ParametricBank parametricBank;
+
+    int maxBlockSize{ 0 };
+
+    LaneBuffer<float> floatLanes;
+    LaneBuffer<double> doubleLanes;
+
+    void setBand(Band& band, const CascadeCoefficients& coefficients, FilterTopology topology, bool bypassed);
+    static void resetBand(Band& band);
+
+    // Clears stages firstStage and up in every lane group, leaving the lower ones ringing
+    void resetStages(Band& band, int firstStage);
+
+    static void processBand(Band& band, LaneBuffer<float>& lanes, int numSamples);
+    static void processBand(Band& band, LaneBuffer<double>& lanes, int numSamples);
+    static void processParametricBank(ParametricBank& bank, LaneBuffer<float>& lanes, int numSamples);
+    void resetParametricBand(int bandIndex);
+};
@@ -0,0 +1,153 @@
+/*
+  ==============================================================================
+
+    LinearPhaseFilter.cpp
+
+  ==============================================================================
+*/
+
+#include "LinearPhaseFilter.h"
+#include "ResponseCurve.h"
+
+int getLinearPhaseKernelLength(double sampleRate) {
+    return juce::nextPowerOfTwo(juce::roundToInt(sampleRate * minimumKernelLengthSeconds));
+}
+
+void LinearPhaseKernelDesigner::prepare(double newSampleRate) {
+    if (newSampleRate != sampleRate) {
+        sampleRate = newSampleRate;
+        kernelLength = getLinearPhaseKernelLength(sampleRate);
+
+        fft = std::make_unique<juce::dsp::FFT>(juce::roundToInt(std::log2(kernelLength)));
+
+        const auto numBins = kernelLength / 2 + 1;
+        halfAngleSines.resize(numBins);
+        bandDecibels.resize(numBins);
+
+        // Bin k sits at k * sampleRate / kernelLength
+        for (int bin = 0; bin < numBins; ++bin) {
+            auto s = std::sin(juce::MathConstants<double>::pi * bin / kernelLength);
+            halfAngleSines[bin] = (float)(s * s);
+        }
+
+        spectrum.resize((size_t)kernelLength * 2);
+    }
+
+    totalDecibels.assign(halfAngleSines.size(), 0.f);
+}
+
+void LinearPhaseKernelDesigner::addBand(const CascadeCoefficients& coefficients) {
+    addSections(coefficients.stages.data(), coefficients.numStages);
+}
+
+void LinearPhaseKernelDesigner::addSections(const BiquadCoefficients* sections, int numSections) {
+    if (numSections == 0)
+        return;
+
+    computeMagnitudesInDecibels(halfAngleSines.data(), (int)halfAngleSines.size(),
+                                sections, numSections, bandDecibels.data());
+
+    juce::FloatVectorOperations::add(totalDecibels.data(), bandDecibels.data(), (int)totalDecibels.size());
+}
+
+juce::AudioBuffer<float> LinearPhaseKernelDesigner::createKernel() {
+    jassert(fft != nullptr);
+
+    // Real, zero phase spectrum in the interleaved complex layout the inverse transform expects
+    std::fill(spectrum.begin(), spectrum.end(), 0.f);
+    for (size_t bin = 0; bin < totalDecibels.size(); ++bin)
+        spectrum[bin * 2] = juce::Decibels::decibelsToGain(totalDecibels[bin]);
+
+    fft->performRealOnlyInverseTransform(spectrum.data());
+
+    // The impulse wraps around sample 0, so rotate it to the centre. The window is
+    // symmetric about the centre too, which keeps the phase exactly linear.
+    juce::AudioBuffer<float> kernel(1, kernelLength);
+    auto* data = kernel.getWritePointer(0);
+
+    const auto half = kernelLength / 2;
+    const auto step = juce::MathConstants<double>::twoPi / kernelLength;
+
+    for (int i = 0; i < kernelLength; ++i) {
+        auto m = double(i - half);
+        auto window = 0.42 + 0.5 * std::cos(step * m) + 0.08 * std::cos(2.0 * step * m);
+
+        data[i] = (float)(spectrum[(size_t)((i + half) & (kernelLength - 1))] * window);
+    }
+
+    return kernel;
+}
+
+void LinearPhaseFilter::prepare(const juce::dsp::ProcessSpec& spec) {
+    const juce::ScopedLock lock(convolutionLock);
+
+    kernelLength.store(getLinearPhaseKernelLength(spec.sampleRate));
+    kernelLoaded.store(false);
+
+    const auto numChannels = (int)spec.numChannels;
+    const auto numConvolutions = (size_t)((numChannels + channelsPerConvolution - 1) / channelsPerConvolution);
+
+    while (convolutions.size() > numConvolutions)
+        convolutions.pop_back();
+
+    while (convolutions.size() < numConvolutions)
+        convolutions.push_back(std::make_unique<juce::dsp::Convolution>(
+            juce::dsp::Convolution::NonUniform{ headPartitionSize }, messageQueue));
+
+    for (size_t i = 0; i < convolutions.size(); ++i) {
+        auto pairSpec = spec;
+        pairSpec.numChannels = (juce::uint32)juce::jmin(channelsPerConvolution, numChannels - (int)i * channelsPerConvolution);
+        convolutions[i]->prepare(pairSpec);
+    }
+}
+
+void LinearPhaseFilter::reset() {
+    for (auto& convolution : convolutions)
+        convolution->reset();
+}
+
+void LinearPhaseFilter::loadKernel(juce::AudioBuffer<float>&& kernel, double kernelSampleRate) {
+    const juce::ScopedLock lock(convolutionLock);
+
+    // A kernel designed for another rate would change the latency, so drop it
+    if (kernel.getNumSamples() != kernelLength.load() || convolutions.empty())
+        return;
+
+    auto load = [kernelSampleRate](juce::dsp::Convolution& convolution, juce::AudioBuffer<float>&& buffer) {
+        convolution.loadImpulseResponse(std::move(buffer), kernelSampleRate,
+                                        juce::dsp::Convolution::Stereo::no,
+                                        juce::dsp::Convolution::Trim::no,
+                                        juce::dsp::Convolution::Normalise::no);
+    };
+
+    // Every pair takes ownership of its kernel, the last one gets the original
+    for (size_t i = 0; i + 1 < convolutions.size(); ++i)
+        load(*convolutions[i], juce::AudioBuffer<float>(kernel));
+
+    load(*convolutions.back(), std::move(kernel));
+}
+
+bool LinearPhaseFilter::process(juce::dsp::AudioBlock<float>& block) {
+    const auto numChannels = block.getNumChannels();
+
+    for (size_t i = 0; i < convolutions.size(); ++i) {
+        auto firstChannel = i * (size_t)channelsPerConvolution;
+        if (firstChannel >= numChannels)
+            break;
+
+        auto pair = block.getSubsetChannelBlock(firstChannel, juce::jmin((size_t)channelsPerConvolution, numChannels - firstChannel));
+        convolutions[i]->process(juce::dsp::ProcessContextReplacing<float>(pair));
+    }
+
+    if (kernelLoaded.load() || convolutions.empty())
+        return false;
+
+    // The convolutions switch to a loaded kernel inside process(), every pair on the same block
+    for (auto& convolution : convolutions) {
+        if (convolution->getCurrentIRSize() != kernelLength.load())
+            return false;
+    }
+
+    kernelLoaded.store(true);
+    return true;
+}
@@ -0,0 +1,88 @@
+/*
+  ==============================================================================
+
+    LinearPhaseFilter.h
+
+    Linear phase alternative to the IIR FilterEngine. The magnitude response
+    of the active bands is sampled on an FFT grid and turned into a
+    symmetric, windowed FIR kernel, which runs through JUCE's non-uniformly
+    partitioned convolution. Kernels are designed on the coefficient
+    designer thread; the convolution loads them on a background thread
+    and crossfades from the previous kernel. juce::dsp::Convolution handles
+    at most two channels, so wider layouts get one instance per pair.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "CoefficientDesign.h"
+
+// Shortest kernel in seconds; the length is rounded up to a power of two
+constexpr double minimumKernelLengthSeconds = 0.25;
+
+int getLinearPhaseKernelLength(double sampleRate);
+
+// Builds kernels from cascades of biquads. Allocates whenever the sample rate changes,
+// so it belongs on a background thread.
+class LinearPhaseKernelDesigner {
+public:
+    // Starts a new kernel with a flat response
+    void prepare(double sampleRate);
+
+    // Multiplies the magnitude response of the cascade into the kernel
+    void addBand(const CascadeCoefficients& coefficients);
+    void addSections(const BiquadCoefficients* sections, int numSections);
+
+    // Zero phase spectrum -> impulse centred on kernelLength / 2 -> Blackman window
+    juce::AudioBuffer<float> createKernel();
+
+    int getKernelLength() const { return kernelLength; }
+
+private:
+    double sampleRate{ 0.0 };
+    int kernelLength{ 0 };
+
+    std::unique_ptr<juce::dsp::FFT> fft;
+
+    // One entry per FFT bin from DC to Nyquist
+    std::vector<float> halfAngleSines, bandDecibels, totalDecibels;
+    std::vector<float> spectrum;
+};
+
+class LinearPhaseFilter {
+public:
+    // Samples handled by the zero latency head of the partitioned convolution
+    static constexpr int headPartitionSize = 256;
+    static constexpr int channelsPerConvolution = 2;
+
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    void reset();
+
+    // Safe from any thread; the new kernel is crossfaded in
+    void loadKernel(juce::AudioBuffer<float>&& kernel, double kernelSampleRate);
+
+    // Returns true on the block where the first kernel took over, which changes the latency
+    bool process(juce::dsp::AudioBlock<float>& block);
+
+    int getKernelLength() const { return kernelLength.load(); }
+
+    // Half the kernel; the non-uniform convolution adds none of its own. Until the first
+    // kernel is in place the convolution passes audio straight through, so that's 0.
+    int getLatencyInSamples() const { return kernelLoaded.load() ? kernelLength.load() / 2 : 0; }
+
+private:
+    // One loader thread shared by every channel pair
+    juce::dsp::ConvolutionMessageQueue messageQueue;
+    std::vector<std::unique_ptr<juce::dsp::Convolution>> convolutions;
+
+    // Held by prepare() and loadKernel(), which run on different threads, never by process()
+    juce::CriticalSection convolutionLock;
+
+    std::atomic<int> kernelLength{ 0 };
+    std::atomic<bool> kernelLoaded{ false };
+};
@@ -225,79 +225,157 @@ juce::String RotarySliderWithLabels::getDisplayString() const{
 }
 
 
+void PopupMenuToggleButton::mouseDown(const juce::MouseEvent& e){
+
+    if (e.mods.isPopupMenu() && onPopupMenu != nullptr){
+
+        onPopupMenu();
+        return;
+    }
+
+    juce::ToggleButton::mouseDown(e);
+}
+
+void PopupMenuToggleButton::mouseUp(const juce::MouseEvent& e){
+
+    if (e.mods.isPopupMenu() && onPopupMenu != nullptr)
+        return;
+
+    juce::ToggleButton::mouseUp(e);
+}
+
+void addChoiceParameterItems(juce::PopupMenu& menu, juce::RangedAudioParameter* param){
+
+    auto* choiceParam = dynamic_cast<juce::AudioParameterChoice*>(param);
+    if (choiceParam == nullptr){
+        jassertfalse;
+        return;
+    }
+
+    for (int i = 0; i < choiceParam->choices.size(); ++i){
+
+        menu.addItem(choiceParam->choices[i], true, choiceParam->getIndex() == i, [choiceParam, i](){
+
+            choiceParam->beginChangeGesture();
+            choiceParam->setValueNotifyingHost(choiceParam->convertTo0to1((float)i));
+            choiceParam->endChangeGesture();
+        });
+    }
+}
+
+
+const juce::Colour leftChannelColour(215u, 239u, 249u);
+const juce::Colour rightChannelColour(215u, 201u, 134u);
+
+// Renders static content once at the display's physical resolution, so paint() only has to blit it
+template<typename DrawFunction>
+juce::Image renderCachedLayer(juce::Rectangle<int> bounds, float scale, bool isOpaque, DrawFunction&& draw){
+
+    juce::Image layer(isOpaque ? juce::Image::RGB : juce::Image::ARGB,
+                      juce::jmax(1, juce::roundToInt(bounds.getWidth() * scale)),
+                      juce::jmax(1, juce::roundToInt(bounds.getHeight() * scale)),
+                      true);
+
+    juce::Graphics g(layer);
+    g.addTransform(juce::AffineTransform::scale(scale));
+    draw(g);
+
+    return layer;
+}
+
+JUCE_IMPLEMENT_SINGLETON(BackgroundImage)
+
+// Bypassed bands carry no values in ChainSettings, so only their flag is compared
+bool isSameParametricBand(const ParametricBandSettings& a, const ParametricBandSettings& b){
+
+    if (a.byPassed || b.byPassed)
+        return a.byPassed == b.byPassed;
+
+    return a.frequency == b.frequency && a.gainInDB == b.gainInDB && a.quality == b.quality && a.type == b.type;
+}
+
+
 ResponseCurveComponent::ResponseCurveComponent(KGP_EQAudioProcessor& p) :
                         audioProcessor(p),
                         leftPathProducer(audioProcessor.leftChannelFifo),
-                        rightPathProducer(audioProcessor.rightChannelFifo){
+                        rightPathProducer(audioProcessor.rightChannelFifo),
+                        analyzerJob(audioProcessor, leftPathProducer, rightPathProducer){
 
+    // Only the fixed bands' parameters are listened to. updateResponseCurve() polls the
+    // parametric bank, which would otherwise add five listeners per band for a few active ones.
     const auto& params = audioProcessor.getParameters();
     for (auto param : params){
 
-        param->addListener(this);
+        auto* rangedParam = dynamic_cast<juce::RangedAudioParameter*>(param);
+        auto mask = rangedParam != nullptr && !rangedParam->paramID.startsWith("Band ")
+                  ? getBandMaskForParameter(rangedParam->paramID) : 0u;
+        parameterBandMasks.push_back(mask);
+
+        if (mask != 0)
+            param->addListener(this);
     }
 
-    updateChain();
+    analyzerRenderer = audioProcessor.apvts.getRawParameterValue("Analyzer Renderer");
+    analyzerEnabled = audioProcessor.apvts.getRawParameterValue("Analyzer Enabled");
+    shouldShowFFTAnalysis = analyzerEnabled->load() > 0.5f;
+
+    setOpaque(true);
 
-    startTimerHz(60);
+    analyzerScheduler->addClient(this);
 }
 
 ResponseCurveComponent::~ResponseCurveComponent(){
 
+    analyzerScheduler->removeClient(this);
+
     const auto& params = audioProcessor.getParameters();
-    for (auto param : params){
+    for (int i = 0; i < params.size(); ++i){
 
-        param->removeListener(this);
+        if (parameterBandMasks[(size_t)i] != 0)
+            params[i]->removeListener(this);
     }
 }
 
-void ResponseCurveComponent::updateResponseCurve(){
+bool ResponseCurveComponent::updateResponseCurve(){
 
     using namespace juce;
     auto responseArea = getAnalysisArea();
 
-    auto w = responseArea.getWidth();
+    // The bands are designed at the oversampled rate, which changes their shape near Nyquist
+    auto sampleRate = audioProcessor.getSampleRate() * getOversamplingFactor(audioProcessor.parameterValues);
+    if (sampleRate <= 0.0)
+        return false;
 
-    auto& lowcut = monoChain.get<ChainPositions::LowCut>();
-    auto& peak = monoChain.get<ChainPositions::Peak>();
-    auto& highcut = monoChain.get<ChainPositions::HighCut>();
+    auto chainSettings = getChainSettings(audioProcessor.parameterValues);
 
-    auto sampleRate = audioProcessor.getSampleRate();
+    auto bands = dirtyBands.exchange(0);
+    if (responseCurveEngine.prepare(responseArea.getWidth(), sampleRate))
+        bands = allBandsMask;
 
-    std::vector<double> mags;
+    if (!std::equal(chainSettings.parametricBands.begin(), chainSettings.parametricBands.end(),
+                    displayedParametricBands.begin(), isSameParametricBand))
+        bands |= bandMask(ChainPositions::Parametric);
 
-    mags.resize(w);
+    if (bands == 0)
+        return false;
 
-    for (int i = 0; i < w; ++i){
-        double mag = 1.f;
-        auto freq = mapToLog10(double(i) / double(w), 20.0, 20000.0);
+    displayedParametricBands = chainSettings.parametricBands;
+    updateCoefficientSet(coefficientSet, chainSettings, sampleRate, bands);
 
-        if (!monoChain.isBypassed<ChainPositions::Peak>())
-            mag *= peak.coefficients->getMagnitudeForFrequency(freq, sampleRate);
+    if (bands & bandMask(ChainPositions::LowCut))
+        responseCurveEngine.setBand(ChainPositions::LowCut, coefficientSet.lowCut, coefficientSet.lowCutByPassed);
 
-        if (!monoChain.isBypassed<ChainPositions::LowCut>()){
-            if (!lowcut.isBypassed<0>())
-                mag *= lowcut.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            if (!lowcut.isBypassed<1>())
-                mag *= lowcut.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            if (!lowcut.isBypassed<2>())
-                mag *= lowcut.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            if (!lowcut.isBypassed<3>())
-                mag *= lowcut.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        }
+    if (bands & bandMask(ChainPositions::Peak))
+        responseCurveEngine.setBand(ChainPositions::Peak, coefficientSet.peak, coefficientSet.peakByPassed);
 
-        if (!monoChain.isBypassed<ChainPositions::HighCut>()){
-            if (!highcut.isBypassed<0>())
-                mag *= highcut.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            if (!highcut.isBypassed<1>())
-                mag *= highcut.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            if (!highcut.isBypassed<2>())
-                mag *= highcut.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            if (!highcut.isBypassed<3>())
-                mag *= highcut.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        }
+    if (bands & bandMask(ChainPositions::HighCut))
+        responseCurveEngine.setBand(ChainPositions::HighCut, coefficientSet.highCut, coefficientSet.highCutByPassed);
 
-        mags[i] = Decibels::gainToDecibels(mag);
-    }
+    if (bands & bandMask(ChainPositions::Parametric))
+        responseCurveEngine.setBand(ChainPositions::Parametric, coefficientSet.parametric.sections.data(),
+                                    coefficientSet.parametric.numActive);
+
+    const auto& mags = responseCurveEngine.getMagnitudesInDecibels();
 
     responseCurve.clear();
 
@@ -307,20 +385,65 @@ void ResponseCurveComponent::updateResponseCurve(){
         return jmap(input, -24.0, 24.0, outputMin, outputMax);
     };
 
+    if (mags.empty())
+        return true;
+
     responseCurve.startNewSubPath(responseArea.getX(), map(mags.front()));
 
     for (size_t i = 1; i < mags.size(); ++i){
         responseCurve.lineTo(responseArea.getX() + i, map(mags[i]));
     }
+
+    return true;
+}
+
+void ResponseCurveComponent::renderLayers(float scale){
+
+    using namespace juce;
+
+    backgroundLayer = renderCachedLayer(getLocalBounds(), scale, true, [this](Graphics& g){
+
+        // (Our component is opaque, so we must completely fill the background with a solid colour)
+        g.fillAll(Colours::black);
+        drawBackgroundGrid(g);
+    });
+
+    foregroundLayer = renderCachedLayer(getLocalBounds(), scale, false, [this](Graphics& g){
+
+        Path border;
+
+        border.setUsingNonZeroWinding(false);
+
+        border.addRoundedRectangle(getRenderArea(), 4);
+        border.addRectangle(getLocalBounds());
+
+        g.setColour(Colours::black);
+
+        g.fillPath(border);
+
+        drawTextLabels(g);
+
+        g.setColour(Colours::orange);
+        g.drawRoundedRectangle(getRenderArea().toFloat(), 4.f, 1.f);
+    });
+
+    layerScale = scale;
 }
 
 void ResponseCurveComponent::paint(juce::Graphics& g){
 
     using namespace juce;
-    // (Our component is opaque, so we must completely fill the background with a solid colour)
-    g.fillAll(Colours::black);
 
-    drawBackgroundGrid(g);
+#if KGP_EQ_ENABLE_OPENGL
+    if (glRenderer.isAttached())
+        return;
+#endif
+
+    auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    if (backgroundLayer.isNull() || scale != layerScale)
+        renderLayers(scale);
+
+    g.drawImage(backgroundLayer, getLocalBounds().toFloat());
 
     auto responseArea = getAnalysisArea();
 
@@ -328,34 +451,20 @@ void ResponseCurveComponent::paint(juce::Graphics& g){
         auto leftChannelFFTPath = leftPathProducer.getPath();
         leftChannelFFTPath.applyTransform(AffineTransform().translation(responseArea.getX(), responseArea.getY()));
 
-        g.setColour(Colour(215u, 239u, 249u));
+        g.setColour(leftChannelColour);
         g.strokePath(leftChannelFFTPath, PathStrokeType(1.f));
 
         auto rightChannelFFTPath = rightPathProducer.getPath();
         rightChannelFFTPath.applyTransform(AffineTransform().translation(responseArea.getX(), responseArea.getY()));
 
-        g.setColour(Colour(215u, 201u, 134u));
+        g.setColour(rightChannelColour);
         g.strokePath(rightChannelFFTPath, PathStrokeType(1.f));
     }
 
     g.setColour(Colours::white);
     g.strokePath(responseCurve, PathStrokeType(2.f));
 
-    Path border;
-
-    border.setUsingNonZeroWinding(false);
-
-    border.addRoundedRectangle(getRenderArea(), 4);
-    border.addRectangle(getLocalBounds());
-
-    g.setColour(Colours::black);
-
-    g.fillPath(border);
-
-    drawTextLabels(g);
-
-    g.setColour(Colours::orange);
-    g.drawRoundedRectangle(getRenderArea().toFloat(), 4.f, 1.f);
+    g.drawImage(foregroundLayer, getLocalBounds().toFloat());
 }
 
 std::vector<float> ResponseCurveComponent::getFrequencies(){
@@ -500,88 +609,258 @@ void ResponseCurveComponent::resized(){
 
     using namespace juce;
 
+    backgroundLayer = {};
+    foregroundLayer = {};
+    displayOutOfDate = true;
+
     responseCurve.preallocateSpace(getWidth() * 3);
     updateResponseCurve();
+
+    analyzerJob.setAnalysisArea(getAnalysisArea().toFloat());
 }
 
 void ResponseCurveComponent::parameterValueChanged(int parameterIndex, float newValue){
-    parametersChanged.set(true);
+    if (juce::isPositiveAndBelow(parameterIndex, (int)parameterBandMasks.size()))
+        dirtyBands.fetch_or(parameterBandMasks[parameterIndex]);
+}
+
+
+int PathProducer::getHopSize(AnalyzerOverlap overlap) const{
+
+    const auto fftSize = leftChannelFFTDataGenerator.getFFTSize();
+
+    switch (overlap){
+    case AnalyzerOverlap::overlap50:
+        return fftSize / 2;
+    case AnalyzerOverlap::overlap75:
+        return fftSize / 4;
+    case AnalyzerOverlap::onePerFrame:
+    default:
+        return 1;
+    }
+}
+
+void PathProducer::prepare(){
+
+    leftChannelFFTDataGenerator.prepare();
+    history.assign(leftChannelFFTDataGenerator.getMaxFFTSize(), 0.f);
+
+    prepared = true;
 }
 
+void PathProducer::process(juce::Rectangle<float> fftBounds, double sampleRate, FFTOrder order, AnalyzerOverlap overlap){
 
-void PathProducer::process(juce::Rectangle<float> fftBounds, double sampleRate){
+    if (!prepared)
+        prepare();
 
-    juce::AudioBuffer<float> tempIncomingBuffer;
-    while (leftChannelFifo->getNumCompleteBuffersAvailable() > 0){
-        if (leftChannelFifo->getAudioBuffer(tempIncomingBuffer)){
-            auto size = tempIncomingBuffer.getNumSamples();
+    if (order != leftChannelFFTDataGenerator.getOrder())
+        leftChannelFFTDataGenerator.changeOrder(order);
 
-            juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, 0),
-                monoBuffer.getReadPointer(0, size),
-                monoBuffer.getNumSamples() - size);
+    const auto windowSize = (int)history.size();
 
-            juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, monoBuffer.getNumSamples() - size),
-                tempIncomingBuffer.getReadPointer(0, 0),
-                size);
+    auto numRead = leftChannelFifo->read(leftChannelFifo->getNumSamplesAvailable(), [this, windowSize](const float* data, int numSamples){
 
-            leftChannelFFTDataGenerator.produceFFTDataForRendering(monoBuffer, -48.f);
+        while (numSamples > 0){
+            auto numToCopy = juce::jmin(numSamples, windowSize - historyWritePosition);
+            juce::FloatVectorOperations::copy(history.data() + historyWritePosition, data, numToCopy);
+
+            historyWritePosition = (historyWritePosition + numToCopy) % windowSize;
+            data += numToCopy;
+            numSamples -= numToCopy;
         }
-    }
+    });
+
+    // Only the newest spectrum is ever drawn, so run at most one FFT per frame and
+    // none at all until a hop's worth of new audio has arrived
+    samplesSinceLastFFT += numRead;
+    if (samplesSinceLastFFT < getHopSize(overlap))
+        return;
+
+    samplesSinceLastFFT = 0;
+
+    leftChannelFFTDataGenerator.produceFFTDataForRendering(history.data(), windowSize, historyWritePosition, -48.f);
 
     const auto fftSize = leftChannelFFTDataGenerator.getFFTSize();
     const auto binWidth = sampleRate / double(fftSize);
 
-    while (leftChannelFFTDataGenerator.getNumAvailableFFTDataBlocks() > 0){
-        std::vector<float> fftData;
-        if (leftChannelFFTDataGenerator.getFFTData(fftData)){
-            pathProducer.generatePath(fftData, fftBounds, fftSize, binWidth, -48.f);
+    // The path is built straight from the generator's buffer, the spectrum is never copied
+    pathProducer.generatePath(leftChannelFFTDataGenerator.getFFTData(), fftBounds, fftSize, binWidth, -48.f);
+}
+
+bool PathProducer::updatePath(){
+
+    bool updated = false;
+    while (pathProducer.getNumPathsAvailable() > 0)
+        updated = pathProducer.getPath(leftChannelFFTPath) || updated;
+
+    return updated;
+}
+
+AnalyzerJob::AnalyzerJob(KGP_EQAudioProcessor& p, PathProducer& left, PathProducer& right) :
+                juce::ThreadPoolJob("KGP_EQ Analyzer"),
+                audioProcessor(p),
+                leftPathProducer(left),
+                rightPathProducer(right){
+
+    analyzerOverlap = audioProcessor.apvts.getRawParameterValue("Analyzer Overlap");
+    analyzerResolution = audioProcessor.apvts.getRawParameterValue("Analyzer Resolution");
+}
+
+void AnalyzerJob::setAnalysisArea(juce::Rectangle<float> area){
+
+    const juce::SpinLock::ScopedLockType lock(areaLock);
+    analysisArea = area;
+}
+
+juce::ThreadPoolJob::JobStatus AnalyzerJob::runJob(){
+
+    juce::Rectangle<float> fftBounds;
+    {
+        const juce::SpinLock::ScopedLockType lock(areaLock);
+        fftBounds = analysisArea;
+    }
+
+    auto sampleRate = audioProcessor.getSampleRate();
+    auto order = static_cast<FFTOrder>(FFTOrder::order_2048 + (int)analyzerResolution->load());
+    auto overlap = static_cast<AnalyzerOverlap>((int)analyzerOverlap->load());
+
+    leftPathProducer.process(fftBounds, sampleRate, order, overlap);
+    rightPathProducer.process(fftBounds, sampleRate, order, overlap);
+
+    return jobHasFinished;
+}
+
+bool ResponseCurveComponent::analyzerFrame(){
+
+    bool needsRepaint = false;
+
+    auto enabled = analyzerEnabled->load() > 0.5f;
+    if (enabled != shouldShowFFTAnalysis)
+        toggleAnalysisEnablement(enabled);
+
+    if (shouldShowFFTAnalysis){
+        needsRepaint = leftPathProducer.updatePath() || needsRepaint;
+        needsRepaint = rightPathProducer.updatePath() || needsRepaint;
+    }
+
+    needsRepaint = updateResponseCurve() || needsRepaint;
+    needsRepaint = std::exchange(displayOutOfDate, false) || needsRepaint;
+
+#if KGP_EQ_ENABLE_OPENGL
+    if (updateRenderer()){
+        if (needsRepaint || !layersUploaded){
+            uploadToRenderer();
+            glRenderer.triggerRepaint();
         }
+
+        return shouldShowFFTAnalysis;
     }
+#endif
+
+    // Everything outside the render area comes from the cached layers and never changes
+    if (needsRepaint)
+        repaint(getRenderArea());
+
+    return shouldShowFFTAnalysis;
+}
 
-    while (pathProducer.getNumPathsAvailable() > 0){
-        pathProducer.getPath(leftChannelFFTPath);
+#if KGP_EQ_ENABLE_OPENGL
+bool ResponseCurveComponent::updateRenderer(){
+
+    auto wantsOpenGL = analyzerRenderer->load() > 0.5f;
+
+    // Switching back to software allows another attempt later
+    if (!wantsOpenGL)
+        openGLFailed = false;
+
+    if (glRenderer.isAttached() && glRenderer.hasFailed())
+        openGLFailed = true;
+
+    auto useOpenGL = wantsOpenGL && !openGLFailed;
+
+    if (useOpenGL && !glRenderer.isAttached()){
+        glRenderer.attachTo(*this);
+        layersUploaded = false;
+    }
+    else if (!useOpenGL && glRenderer.isAttached()){
+        glRenderer.detach();
+        repaint();
     }
+
+    return useOpenGL;
 }
 
-void ResponseCurveComponent::timerCallback(){
+void ResponseCurveComponent::uploadToRenderer(){
 
-    if (shouldShowFFTAnalysis){
-        auto fftBounds = getAnalysisArea().toFloat();
-        auto sampleRate = audioProcessor.getSampleRate();
+    auto scale = glRenderer.getRenderingScale();
+    if (backgroundLayer.isNull() || scale != layerScale){
+        renderLayers(scale);
+        layersUploaded = false;
+    }
 
-        leftPathProducer.process(fftBounds, sampleRate);
-        rightPathProducer.process(fftBounds, sampleRate);
+    if (!layersUploaded){
+        glRenderer.setLayers(backgroundLayer, foregroundLayer);
+        layersUploaded = true;
     }
 
-    if (parametersChanged.compareAndSetBool(false, true)){
-        updateChain();
-        updateResponseCurve();
+    if (shouldShowFFTAnalysis){
+        auto offset = getAnalysisArea().getPosition().toFloat();
+
+        glRenderer.setLine(ResponseCurveGLRenderer::leftSpectrum, leftPathProducer.getPath(), offset, leftChannelColour, 1.f);
+        glRenderer.setLine(ResponseCurveGLRenderer::rightSpectrum, rightPathProducer.getPath(), offset, rightChannelColour, 1.f);
+    }
+    else{
+        glRenderer.hideLine(ResponseCurveGLRenderer::leftSpectrum);
+        glRenderer.hideLine(ResponseCurveGLRenderer::rightSpectrum);
     }
 
-    repaint();
+    glRenderer.setLine(ResponseCurveGLRenderer::response, responseCurve, {}, juce::Colours::white, 2.f);
 }
+#endif
+
+void ResponseCurveComponent::showAnalyzerMenu(juce::Component& target){
+
+    juce::PopupMenu menu;
+
+    menu.addSectionHeader("Analyzer Resolution");
+    addChoiceParameterItems(menu, audioProcessor.apvts.getParameter("Analyzer Resolution"));
+
+    menu.addSectionHeader("Analyzer Overlap");
+    addChoiceParameterItems(menu, audioProcessor.apvts.getParameter("Analyzer Overlap"));
+
+    menu.addSectionHeader("Analyzer Renderer");
+    addChoiceParameterItems(menu, audioProcessor.apvts.getParameter("Analyzer Renderer"));
 
-void ResponseCurveComponent::updateChain(){
+    menu.addSectionHeader("Test Signal");
+    addChoiceParameterItems(menu, audioProcessor.apvts.getParameter("Test Signal"));
 
-    auto chainSettings = getChainSettings(audioProcessor.apvts);
+    // Block timing isn't part of the session, it stays with this instance
+    auto& monitor = audioProcessor.getAudioThreadMonitor();
 
-    monoChain.setBypassed<ChainPositions::LowCut>(chainSettings.lowCutByPassed);
-    monoChain.setBypassed<ChainPositions::Peak>(chainSettings.peakByPassed);
-    monoChain.setBypassed<ChainPositions::HighCut>(chainSettings.highCutByPassed);
+    menu.addSectionHeader("Diagnostics");
+    menu.addItem("Block Timing", true, monitor.isEnabled(), [&monitor](){
 
-    auto peakCoefficients = makePeakFilter(chainSettings, audioProcessor.getSampleRate());
-    updateCoefficients(monoChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
+        monitor.setEnabled(!monitor.isEnabled());
+    });
 
-    auto lowCutCoefficients = makeLowCutFilter(chainSettings, audioProcessor.getSampleRate());
-    auto highCutCoefficients = makeHighCutFilter(chainSettings, audioProcessor.getSampleRate());
+    menu.addItem("Copy Block Timing Stats", monitor.isEnabled(), false, [&processor = audioProcessor, &monitor](){
 
-    UpdateCutFilter(monoChain.get<ChainPositions::LowCut>(),
-        lowCutCoefficients,
-        chainSettings.lowCutSlope);
+        juce::String report;
+        report << processor.getName() << " block timing, " << processor.getSampleRate() << " Hz, "
+               << processor.getBlockSize() << " samples, latency " << processor.getLatencySamples() << " samples\n"
+               << "DSP load: " << juce::String(processor.getDSPLoad() * 100.0, 1) << "%, xruns: "
+               << processor.getXRunCount() << "\n"
+               << monitor.getStats().toString();
 
-    UpdateCutFilter(monoChain.get<ChainPositions::HighCut>(),
-        highCutCoefficients,
-        chainSettings.highCutSlope);
+        juce::SystemClipboard::copyTextToClipboard(report);
+    });
+
+    menu.addItem("Reset Block Timing", monitor.isEnabled(), false, [&monitor](){
+
+        monitor.resetStats();
+    });
+
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&target));
 }
 
 juce::Rectangle<int> ResponseCurveComponent::getRenderArea(){
@@ -618,16 +897,12 @@ KGP_EQAudioProcessorEditor::KGP_EQAudioProcessorEditor (KGP_EQAudioProcessor& p)
 
     responseCurveComponent(audioProcessor),
 
-    peakFreqSliderAttachment(audioProcessor.apvts, "Peak Frequency", peakFreqSlider),
-    peakGainSliderAttachment(audioProcessor.apvts, "Peak Gain", peakGainSlider),
-    peakQualitySliderAttachment(audioProcessor.apvts, "Peak Quality", peakQualitySlider),
     lowCutFreqSliderAttachment(audioProcessor.apvts, "Low-Cut Frequency", lowCutFreqSlider),
     highCutFreqSliderAttachment(audioProcessor.apvts, "High-Cut Frequency", highCutFreqSlider),
     lowCutSlopeSliderAttachment(audioProcessor.apvts, "Low-Cut Slope", lowCutSlopeSlider),
     highCutSlopeSliderAttachment(audioProcessor.apvts, "High-Cut Slope", highCutSlopeSlider),
 
     lowcutBypassButtonAttachment(audioProcessor.apvts, "Low-Cut Bypassed", lowcutBypassButton),
-    peakBypassButtonAttachment(audioProcessor.apvts, "Peak Bypassed", peakBypassButton),
     highcutBypassButtonAttachment(audioProcessor.apvts, "High-Cut Bypassed", highcutBypassButton),
     analyzerEnabledButtonAttachment(audioProcessor.apvts, "Analyzer Enabled", analyzerEnabledButton)
 {
@@ -700,21 +975,64 @@ KGP_EQAudioProcessorEditor::KGP_EQAudioProcessorEditor (KGP_EQAudioProcessor& p)
         }
     };
 
-    analyzerEnabledButton.onClick = [safePtr](){
+    lowcutBypassButton.onPopupMenu = [safePtr](){
+
+        if (auto* comp = safePtr.getComponent())
+            comp->showBandMenu("Low-Cut", comp->lowcutBypassButton);
+    };
+
+    peakBypassButton.onPopupMenu = [safePtr](){
+
+        if (auto* comp = safePtr.getComponent())
+            comp->showBandMenu(comp->selectedBand, comp->peakBypassButton);
+    };
+
+    highcutBypassButton.onPopupMenu = [safePtr](){
+
+        if (auto* comp = safePtr.getComponent())
+            comp->showBandMenu("High-Cut", comp->highcutBypassButton);
+    };
+
+    bandSelector.addItem("Peak", 1);
+    for (int i = 0; i < maxParametricBands; ++i)
+        bandSelector.addItem(getParametricBandParameterIDs(i).prefix, i + 2);
+
+    bandSelector.onChange = [safePtr](){
 
         if (auto* comp = safePtr.getComponent()){
 
-            auto enabled = comp->analyzerEnabledButton.getToggleState();
-            
-            comp->responseCurveComponent.toggleAnalysisEnablement(enabled);
+            auto index = comp->bandSelector.getSelectedItemIndex();
+            comp->selectBand(index <= 0 ? juce::String("Peak") : getParametricBandParameterIDs(index - 1).prefix);
         }
     };
 
+    bandSelector.setSelectedId(1, juce::dontSendNotification);
+    selectBand("Peak");
+
+    analyzerEnabledButton.onPopupMenu = [safePtr](){
+
+        if (auto* comp = safePtr.getComponent())
+            comp->responseCurveComponent.showAnalyzerMenu(comp->analyzerEnabledButton);
+    };
+
+    dspLoadLabel.setFont(12.f);
+    dspLoadLabel.setColour(juce::Label::textColourId, juce::Colours::grey);
+    dspLoadLabel.setJustificationType(juce::Justification::centredLeft);
+    dspLoadLabel.setMinimumHorizontalScale(0.7f);
+    dspLoadLabel.setInterceptsMouseClicks(false, false);
+
     setSize (480, 500);
+
+    audioProcessor.setEditorAttached(true);
+
+    timerCallback();
+    startTimerHz(4);
 }
 
 KGP_EQAudioProcessorEditor::~KGP_EQAudioProcessorEditor()
 {
+    audioProcessor.setEditorAttached(false);
+
     peakBypassButton.setLookAndFeel(nullptr);
     highcutBypassButton.setLookAndFeel(nullptr);
     lowcutBypassButton.setLookAndFeel(nullptr);
@@ -724,12 +1042,23 @@ KGP_EQAudioProcessorEditor::~KGP_EQAudioProcessorEditor()
 
 //==============================================================================
 void KGP_EQAudioProcessorEditor::paint (juce::Graphics& g)
+{
+    auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    if (backgroundLayer.isNull() || scale != backgroundLayerScale){
+
+        backgroundLayer = renderCachedLayer(getLocalBounds(), scale, true, [this](juce::Graphics& layer){ drawBackground(layer); });
+        backgroundLayerScale = scale;
+    }
+
+    g.drawImage(backgroundLayer, getLocalBounds().toFloat());
+}
+
+void KGP_EQAudioProcessorEditor::drawBackground(juce::Graphics& g)
 {
     // (Our component is opaque, so we must completely fill the background with a solid colour)
     using namespace juce;
 
-    Image background = ImageCache::getFromMemory(BinaryData::MetallicBackground_jpg, BinaryData::MetallicBackground_jpgSize);
-    g.drawImageAt(background, 0, 0);
+    g.drawImageAt(BackgroundImage::getInstance()->image, 0, 0);
 
     Path curve;
 
@@ -791,6 +1120,8 @@ void KGP_EQAudioProcessorEditor::resized()
     // This is generally where you'll want to lay out the positions of any
     // subcomponents in your editor..
 
+    backgroundLayer = {};
+
     auto bounds = getLocalBounds();
     bounds.removeFromTop(4);
 
@@ -802,6 +1133,11 @@ void KGP_EQAudioProcessorEditor::resized()
 
     analyzerEnabledButton.setBounds(analyzerEnabledArea);
 
+    auto bandSelectorArea = getLocalBounds().removeFromTop(29).removeFromRight(100).reduced(4, 2);
+    bandSelector.setBounds(bandSelectorArea);
+
+    dspLoadLabel.setBounds(analyzerEnabledArea.getRight() + 5, analyzerEnabledArea.getY(), 65, analyzerEnabledArea.getHeight());
+
     bounds.removeFromTop(5);
 
     float hRatio = 25.f / 100.f; //JUCE_LIVE_CONSTANT(25) / 100.f;
@@ -829,6 +1165,84 @@ void KGP_EQAudioProcessorEditor::resized()
 }
 
 
+void KGP_EQAudioProcessorEditor::showBandMenu(const juce::String& bandName, juce::Component& target){
+
+    juce::PopupMenu menu;
+
+    // The parametric bands always run as float TDF-II and have a type instead
+    if (auto* topology = audioProcessor.apvts.getParameter(bandName + " Topology")){
+
+        menu.addSectionHeader(bandName + " Topology");
+        addChoiceParameterItems(menu, topology);
+    }
+    else{
+
+        menu.addSectionHeader(bandName + " Type");
+        addChoiceParameterItems(menu, audioProcessor.apvts.getParameter(bandName + " Type"));
+    }
+
+    if (bandName == "Peak"){
+
+        menu.addSectionHeader("Peak Design");
+        addChoiceParameterItems(menu, audioProcessor.apvts.getParameter("Peak Design"));
+    }
+
+    // Shared by all bands, but this is where the per-band processing options live
+    menu.addSectionHeader("Control Rate");
+    addChoiceParameterItems(menu, audioProcessor.apvts.getParameter("Control Rate"));
+
+    menu.addSectionHeader("Phase Mode");
+    addChoiceParameterItems(menu, audioProcessor.apvts.getParameter("Phase Mode"));
+
+    menu.addSectionHeader("Oversampling");
+    addChoiceParameterItems(menu, audioProcessor.apvts.getParameter("Oversampling"));
+
+    // What the current choices cost
+    juce::String cost;
+    cost << "Latency: " << audioProcessor.getLatencySamples() << " samples, DSP load: "
+         << juce::roundToInt(audioProcessor.getDSPLoad() * 100.0) << "%";
+    menu.addItem(cost, false, false, nullptr);
+
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&target));
+}
+
+
+void KGP_EQAudioProcessorEditor::selectBand(const juce::String& prefix){
+
+    auto& apvts = audioProcessor.apvts;
+    selectedBand = prefix;
+
+    peakFreqSliderAttachment.reset();
+    peakGainSliderAttachment.reset();
+    peakQualitySliderAttachment.reset();
+    peakBypassButtonAttachment.reset();
+
+    peakFreqSlider.setParameter(*apvts.getParameter(prefix + " Frequency"));
+    peakGainSlider.setParameter(*apvts.getParameter(prefix + " Gain"));
+    peakQualitySlider.setParameter(*apvts.getParameter(prefix + " Quality"));
+
+    peakFreqSliderAttachment = std::make_unique<Attachment>(apvts, prefix + " Frequency", peakFreqSlider);
+    peakGainSliderAttachment = std::make_unique<Attachment>(apvts, prefix + " Gain", peakGainSlider);
+    peakQualitySliderAttachment = std::make_unique<Attachment>(apvts, prefix + " Quality", peakQualitySlider);
+    peakBypassButtonAttachment = std::make_unique<ButtonAttachment>(apvts, prefix + " Bypassed", peakBypassButton);
+
+    // The attachment only notifies when the toggle state actually changed
+    if (peakBypassButton.onClick)
+        peakBypassButton.onClick();
+}
+
+void KGP_EQAudioProcessorEditor::timerCallback()
+{
+    juce::String text;
+    text << "DSP " << juce::roundToInt(audioProcessor.getDSPLoad() * 100.0) << "%";
+
+    auto& monitor = audioProcessor.getAudioThreadMonitor();
+    if (monitor.isEnabled())
+        text << ", worst " << juce::roundToInt(monitor.getStats().worstLoad * 100.0) << "%";
+
+    dspLoadLabel.setText(text, juce::dontSendNotification);
+}
+
 std::vector<juce::Component*> KGP_EQAudioProcessorEditor::getComps(){
     return
     {
@@ -844,6 +1258,8 @@ std::vector<juce::Component*> KGP_EQAudioProcessorEditor::getComps(){
         &lowcutBypassButton,
         &peakBypassButton,
         &highcutBypassButton,
-        &analyzerEnabledButton
+        &analyzerEnabledButton,
+        &bandSelector,
+        &dspLoadLabel
     };
 }
\ No newline at end of file
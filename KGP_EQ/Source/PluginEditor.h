@@ -17,6 +17,10 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "FastMath.h"
+#include "AnalyzerScheduler.h"
+#include "ResponseCurve.h"
+#include "ResponseCurveGL.h"
 
 
 enum FFTOrder {
@@ -25,60 +29,71 @@ enum FFTOrder {
     order_8192 = 13
 };
 
+// Minimum amount of new audio between two analyzer FFTs
+enum AnalyzerOverlap {
+    onePerFrame,
+    overlap50,
+    overlap75
+};
+
 template<typename BlockType>
 struct FFTDataGenerator {
-    void produceFFTDataForRendering(const juce::AudioBuffer<float>& audioData, const float negativeInfinity) {
+    // history is a circular buffer of historySize samples; the window ends just before writePosition.
+    // The result stays in the generator until the next call, see getFFTData().
+    void produceFFTDataForRendering(const float* history, int historySize, int writePosition, const float negativeInfinity) {
         const auto fftSize = getFFTSize();
-        auto* readIndex = audioData.getReadPointer(0);
-        std::copy(readIndex, readIndex + fftSize, fftData.begin());
+        jassert(fftSize <= historySize);
+
+        auto start = (writePosition - fftSize + historySize) % historySize;
+        auto numToEnd = juce::jmin(fftSize, historySize - start);
+
+        std::copy(history + start, history + start + numToEnd, fftData.begin());
+        std::copy(history, history + (fftSize - numToEnd), fftData.begin() + numToEnd);
+
+        auto& window = *windows[order - FFTOrder::order_2048];
+        auto& forwardFFT = *ffts[order - FFTOrder::order_2048];
 
-        window->multiplyWithWindowingTable(fftData.data(), fftSize);
+        window.multiplyWithWindowingTable(fftData.data(), fftSize);
         
-        forwardFFT->performFrequencyOnlyForwardTransform(fftData.data());
+        forwardFFT.performFrequencyOnlyForwardTransform(fftData.data());
 
         int numBins = (int)fftSize / 2;
-        for (int i = 0; i < numBins; i++) {
-            auto v = fftData[i];
-            if (!std::isinf(v) && !std::isnan(v)) {
-                v /= float(numBins);
-            }
-            else {
-                v = 0.f;
-            }
-            fftData[i] = v;
-        }
+        magnitudesToDecibels(fftData.data(), numBins, 1.f / float(numBins), negativeInfinity);
+    }
+
+    // Builds the FFT plans and windows for every FFTOrder up front, so changeOrder never allocates
+    void prepare() {
+        for (int i = 0; i < numOrders; i++) {
+            auto fftOrder = FFTOrder::order_2048 + i;
+            auto fftSize = 1 << fftOrder;
 
-        for (int i = 0; i < numBins; i++) {
-            fftData[i] = juce::Decibels::gainToDecibels(fftData[i], negativeInfinity);
+            ffts[i] = std::make_unique<juce::dsp::FFT>(fftOrder);
+            windows[i] = std::make_unique<juce::dsp::WindowingFunction<float>>(fftSize, juce::dsp::WindowingFunction<float>::blackmanHarris);
         }
-        fftDataFifo.push(fftData);
+
+        fftData.clear();
+        fftData.resize(getMaxFFTSize() * 2, 0);
     }
 
     void changeOrder(FFTOrder newOrder) {
+        jassert(ffts[newOrder - FFTOrder::order_2048] != nullptr);
         order = newOrder;
-        auto fftSize = getFFTSize();
-
-        forwardFFT = std::make_unique<juce::dsp::FFT>(order);
-        window = std::make_unique<juce::dsp::WindowingFunction<float>>(fftSize, juce::dsp::WindowingFunction<float>::blackmanHarris);
-        
-        fftData.clear();
-        fftData.resize(fftSize * 2, 0);
-
-        fftDataFifo.prepare(fftData.size());
     }
 
+    FFTOrder getOrder() const { return order; }
     int getFFTSize() const { return 1 << order; }
-    int getNumAvailableFFTDataBlocks() const { return fftDataFifo.getNumAvailableForReading(); }
-    
-    bool getFFTData(BlockType& fftData) { return fftDataFifo.pull(fftData); }
+    static int getMaxFFTSize() { return 1 << FFTOrder::order_8192; }
+
+    // Decibels for the first getFFTSize() / 2 bins of the last produced spectrum
+    const BlockType& getFFTData() const { return fftData; }
 
 private:
-    FFTOrder order;
-    BlockType fftData;
-    std::unique_ptr<juce::dsp::FFT> forwardFFT;
-    std::unique_ptr<juce::dsp::WindowingFunction<float>> window;
+    static constexpr int numOrders = FFTOrder::order_8192 - FFTOrder::order_2048 + 1;
 
-    Fifo<BlockType> fftDataFifo;
+    FFTOrder order = FFTOrder::order_2048;
+    BlockType fftData;
+    std::array<std::unique_ptr<juce::dsp::FFT>, numOrders> ffts;
+    std::array<std::unique_ptr<juce::dsp::WindowingFunction<float>>, numOrders> windows;
 };
 
 template<typename PathType>
@@ -92,36 +107,31 @@ struct AnalyzerPathGenerator {
     {
         auto top = fftBounds.getY();
         auto bottom = fftBounds.getHeight();
-        auto width = fftBounds.getWidth();
+        auto numColumns = juce::jmax(1, (int)fftBounds.getWidth());
 
         int numBins = (int)fftSize / 2;
+
+        if (numColumns != tableNumColumns || numBins != tableNumBins || binWidth != tableBinWidth)
+            buildColumnTable(numColumns, numBins, binWidth);
+
         PathType p;
-        p.preallocateSpace(3 * (int)fftBounds.getWidth());
+        p.preallocateSpace(3 * (int)columnSpans.size());
 
         auto map = [bottom, top, negativeInfinity](float v)
         {
             return juce::jmap(v, negativeInfinity, 0.f, float(bottom + 10), top);
         };
 
-        auto y = map(renderData[0]);
+        // One vertex per pixel column, at the loudest bin that lands in it
+        for (size_t i = 0; i < columnSpans.size(); ++i) {
+            const auto& span = columnSpans[i];
+            auto peak = juce::FloatVectorOperations::findMaximum(renderData.data() + span.firstBin, span.numBins);
+            auto y = map(peak);
 
-        if (std::isnan(y) || std::isinf(y)) {
-            y = bottom;
-        }
-
-        p.startNewSubPath(0, y);
-
-        const int pathResolution = 2;
-
-        for (int binNum = 1; binNum < numBins; binNum += pathResolution) {
-            y = map(renderData[binNum]);
-
-            if (!std::isnan(y) && !std::isinf(y)) {
-                auto binFreq = binNum * binWidth;
-                auto normalizedBinX = juce::mapFromLog10(binFreq, 20.f, 20000.f);
-                int binX = std::floor(normalizedBinX * width);
-                p.lineTo(binX, y);
-            }
+            if (i == 0)
+                p.startNewSubPath((float)span.column, y);
+            else
+                p.lineTo((float)span.column, y);
         }
 
         pathFifo.push(p);
@@ -136,7 +146,45 @@ struct AnalyzerPathGenerator {
     }
 
 private:
-    Fifo<PathType> pathFifo;
+    // A run of consecutive bins that all map to the same pixel column
+    struct ColumnSpan {
+        int column;
+        int firstBin;
+        int numBins;
+    };
+
+    // Bins rise monotonically in frequency, so each column owns one contiguous run.
+    // Bins below 20 Hz fold into the first column, bins above 20 kHz are dropped.
+    void buildColumnTable(int numColumns, int numBins, float binWidth) {
+        columnSpans.clear();
+        columnSpans.reserve(numColumns);
+
+        for (int binNum = 0; binNum < numBins; ++binNum) {
+            auto binFreq = juce::jmax(binNum * binWidth, 20.f);
+            auto column = (int)std::floor(juce::mapFromLog10(binFreq, 20.f, 20000.f) * numColumns);
+
+            if (column >= numColumns)
+                break;
+
+            if (!columnSpans.empty() && columnSpans.back().column == column)
+                ++columnSpans.back().numBins;
+            else
+                columnSpans.push_back({ column, binNum, 1 });
+        }
+
+        tableNumColumns = numColumns;
+        tableNumBins = numBins;
+        tableBinWidth = binWidth;
+    }
+
+    std::vector<ColumnSpan> columnSpans;
+    int tableNumColumns = 0;
+    int tableNumBins = 0;
+    float tableBinWidth = 0.f;
+
+    // One path per analyzer frame; the message thread drains them every frame, the
+    // spare slots cover a frame where it runs late
+    Fifo<PathType, 4> pathFifo;
 };
 
 struct LookAndFeel : juce::LookAndFeel_V4 {
@@ -175,6 +223,12 @@ struct RotarySliderWithLabels : juce::Slider{
     int getTextHeight() const { return 14; }
     juce::String getDisplayString() const;
 
+    // Detach any attachment first, it holds on to the old parameter
+    void setParameter(juce::RangedAudioParameter& rap){
+        param = &rap;
+        repaint();
+    }
+
 private:
     LookAndFeel lnf;
 
@@ -184,26 +238,60 @@ private:
 
 struct PathProducer {
     PathProducer(SingleChannelSampleFifo<KGP_EQAudioProcessor::BlockType>& scsf) :
-    leftChannelFifo(&scsf) {
-        leftChannelFFTDataGenerator.changeOrder(FFTOrder::order_2048);
-        monoBuffer.setSize(1, leftChannelFFTDataGenerator.getFFTSize());
-    }
-    void process(juce::Rectangle<float> fftBounds, double sampleRate);
+    leftChannelFifo(&scsf) { }
+
+    // Called on the analyzer thread; finished paths are queued for updatePath()
+    void process(juce::Rectangle<float> fftBounds, double sampleRate, FFTOrder order, AnalyzerOverlap overlap);
+
+    // Called on the message thread; picks up the newest finished path, if any
+    bool updatePath();
+
     juce::Path getPath() {
         return leftChannelFFTPath;
     }
 
 private:
     SingleChannelSampleFifo<KGP_EQAudioProcessor::BlockType>* leftChannelFifo;
-    juce::AudioBuffer<float> monoBuffer;
+
+    // The FFT plans, windows and history are built by the first analyzer frame, so an
+    // editor that never shows the analyzer never allocates them
+    bool prepared = false;
+    void prepare();
+
+    // The most recent samples, enough for the largest FFTOrder, written circularly
+    std::vector<float> history;
+    int historyWritePosition = 0;
+    int samplesSinceLastFFT = 0;
+
+    int getHopSize(AnalyzerOverlap overlap) const;
+
     FFTDataGenerator<std::vector<float>> leftChannelFFTDataGenerator;
     AnalyzerPathGenerator<juce::Path> pathProducer;
     juce::Path leftChannelFFTPath;
 };
 
+// One analyzer frame for both channels, run on the shared AnalyzerScheduler pool
+struct AnalyzerJob : juce::ThreadPoolJob {
+    AnalyzerJob(KGP_EQAudioProcessor& p, PathProducer& left, PathProducer& right);
+
+    void setAnalysisArea(juce::Rectangle<float> area);
+    JobStatus runJob() override;
+
+private:
+    KGP_EQAudioProcessor& audioProcessor;
+    PathProducer& leftPathProducer;
+    PathProducer& rightPathProducer;
+
+    std::atomic<float>* analyzerOverlap = nullptr;
+    std::atomic<float>* analyzerResolution = nullptr;
+
+    juce::SpinLock areaLock;
+    juce::Rectangle<float> analysisArea;
+};
+
 struct ResponseCurveComponent : juce::Component,
     juce::AudioProcessorParameter::Listener,
-    juce::Timer{
+    AnalyzerScheduler::Client{
 
     ResponseCurveComponent(KGP_EQAudioProcessor&);
     ~ResponseCurveComponent();
@@ -212,29 +300,64 @@ struct ResponseCurveComponent : juce::Component,
 
     void parameterGestureChanged(int parameterIndex, bool gestureIsStarting) override { }
 
-    void timerCallback() override;
+    bool isAnalyzerVisible() override { return isShowing(); }
+    bool analyzerFrame() override;
+    juce::ThreadPoolJob& getAnalyzerJob() override { return analyzerJob; }
 
     void paint(juce::Graphics& g) override;
     void resized() override;
 
+    void showAnalyzerMenu(juce::Component& target);
+
     void toggleAnalysisEnablement(bool enabled)
     {
         shouldShowFFTAnalysis = enabled;
+        displayOutOfDate = true;
     }
 private:
     KGP_EQAudioProcessor& audioProcessor;
 
+    // Follows "Analyzer Enabled", so a session restore or host automation shows up too
     bool shouldShowFFTAnalysis = true;
+    std::atomic<float>* analyzerEnabled = nullptr;
 
-    juce::Atomic<bool> parametersChanged{ false };
+    // Forces the next frame to redraw even if no new data arrived
+    bool displayOutOfDate = true;
 
-    MonoChain monoChain;
+    std::atomic<float>* analyzerRenderer = nullptr;
 
-    void updateResponseCurve();
+    // Bands whose parameters changed since the curve was last rebuilt, and the
+    // band each parameter index belongs to (parameter callbacks can come from any thread)
+    std::atomic<juce::uint32> dirtyBands{ allBandsMask };
+    std::vector<juce::uint32> parameterBandMasks;
+
+    // The bank as last drawn; compared every frame instead of listening to its parameters
+    std::array<ParametricBandSettings, maxParametricBands> displayedParametricBands;
+
+    CoefficientSet coefficientSet;
+    ResponseCurveEngine responseCurveEngine;
+
+    // Returns true if the curve had to be rebuilt
+    bool updateResponseCurve();
 
     juce::Path responseCurve;
 
-    void updateChain();
+    // Grid underneath and border, labels on top; rebuilt on resize or a display scale change
+    juce::Image backgroundLayer, foregroundLayer;
+    float layerScale = 0.f;
+
+    void renderLayers(float scale);
+
+#if KGP_EQ_ENABLE_OPENGL
+    // Takes over from paint() while "Analyzer Renderer" is OpenGL and the context works
+    ResponseCurveGLRenderer glRenderer;
+    bool openGLFailed = false;
+    bool layersUploaded = false;
+
+    // Attaches or detaches the renderer to match the parameter; returns true while it is in use
+    bool updateRenderer();
+    void uploadToRenderer();
+#endif
 
     void drawBackgroundGrid(juce::Graphics& g);
     void drawTextLabels(juce::Graphics& g);
@@ -248,12 +371,28 @@ private:
     juce::Rectangle<int> getAnalysisArea();
 
     PathProducer leftPathProducer, rightPathProducer;
+    AnalyzerJob analyzerJob;
+
+    juce::SharedResourcePointer<AnalyzerScheduler> analyzerScheduler;
+
+#if JUCE_MAJOR_VERSION >= 7
+    // Declared after the scheduler, which it calls into
+    juce::VBlankAttachment vblankAttachment{ this, [this](){ analyzerScheduler->vblank(); } };
+#endif
+};
+
+// Toggle button that hands right clicks to onPopupMenu instead of toggling
+struct PopupMenuToggleButton : juce::ToggleButton {
+    std::function<void()> onPopupMenu;
+
+    void mouseDown(const juce::MouseEvent& e) override;
+    void mouseUp(const juce::MouseEvent& e) override;
 };
 
-struct PowerButton : juce::ToggleButton { };
+struct PowerButton : PopupMenuToggleButton { };
 
 
-struct AnalyzerButton : juce::ToggleButton{
+struct AnalyzerButton : PopupMenuToggleButton{
     void resized() override{
         auto bounds = getLocalBounds();
         auto insetRect = bounds.reduced(4);
@@ -274,10 +413,22 @@ struct AnalyzerButton : juce::ToggleButton{
 };
 
 
+// The background JPEG, decoded the first time an editor draws and shared by every editor
+// after that. DeletedAtShutdown frees it while JUCE shuts down, before the image backends go.
+struct BackgroundImage : juce::DeletedAtShutdown {
+    ~BackgroundImage() override { clearSingletonInstance(); }
+
+    const juce::Image image{ juce::ImageFileFormat::loadFrom(BinaryData::MetallicBackground_jpg,
+                                                             BinaryData::MetallicBackground_jpgSize) };
+
+    JUCE_DECLARE_SINGLETON(BackgroundImage, false)
+};
+
 //==============================================================================
 /**
 */
-class KGP_EQAudioProcessorEditor  : public juce::AudioProcessorEditor
+class KGP_EQAudioProcessorEditor  : public juce::AudioProcessorEditor,
+                                    private juce::Timer
 {
 public:
     KGP_EQAudioProcessorEditor (KGP_EQAudioProcessor&);
@@ -305,10 +456,12 @@ private:
     using APVTS = juce::AudioProcessorValueTreeState;
     using Attachment = APVTS::SliderAttachment;
 
-    Attachment  peakFreqSliderAttachment,
-                peakGainSliderAttachment,
-                peakQualitySliderAttachment,
-                lowCutFreqSliderAttachment,
+    // The middle column controls whichever band the selector shows
+    std::unique_ptr<Attachment> peakFreqSliderAttachment,
+                                peakGainSliderAttachment,
+                                peakQualitySliderAttachment;
+
+    Attachment  lowCutFreqSliderAttachment,
                 highCutFreqSliderAttachment,
                 lowCutSlopeSliderAttachment,
                 highCutSlopeSliderAttachment;
@@ -321,11 +474,30 @@ private:
     using ButtonAttachment = APVTS::ButtonAttachment;
 
     ButtonAttachment lowcutBypassButtonAttachment,
-                        peakBypassButtonAttachment,
                         highcutBypassButtonAttachment,
                         analyzerEnabledButtonAttachment;
 
+    std::unique_ptr<ButtonAttachment> peakBypassButtonAttachment;
+
+    // "Peak" or one of the parametric band prefixes
+    juce::ComboBox bandSelector;
+    juce::String selectedBand{ "Peak" };
+
+    void selectBand(const juce::String& prefix);
+
+    // DSP load, plus the worst block while block timing is on
+    juce::Label dspLoadLabel;
+
+    void timerCallback() override;
+
     LookAndFeel lnf;
 
+    juce::Image backgroundLayer;
+    float backgroundLayerScale = 0.f;
+
+    void drawBackground(juce::Graphics& g);
+
+    void showBandMenu(const juce::String& bandName, juce::Component& target);
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (KGP_EQAudioProcessorEditor)
 };
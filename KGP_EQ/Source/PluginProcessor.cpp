@@ -14,7 +14,16 @@
 */
 
 #include "PluginProcessor.h"
-#include "PluginEditor.h"
+
+// Set by the benchmark, which builds the processor without the editor or BinaryData
+#ifndef KGP_EQ_HEADLESS
+ #define KGP_EQ_HEADLESS 0
+#endif
+
+#if ! KGP_EQ_HEADLESS
+ #include "PluginEditor.h"
+#endif
+#include "BinaryState.h"
 
 //==============================================================================
 KGP_EQAudioProcessor::KGP_EQAudioProcessor()
@@ -29,10 +38,26 @@ KGP_EQAudioProcessor::KGP_EQAudioProcessor()
                        )
 #endif
 {
+    for (auto* param : getParameters()) {
+        if (auto* rangedParam = dynamic_cast<juce::RangedAudioParameter*>(param))
+            apvts.addParameterListener(rangedParam->paramID, this);
+    }
+
+    setAnalyzerConsumer(analyzerEnabledBit, apvts.getRawParameterValue("Analyzer Enabled")->load() > 0.5f);
+
+    coefficientDesigner.startThread();
+
+    startTimerHz(latencyPollHz);
 }
 
 KGP_EQAudioProcessor::~KGP_EQAudioProcessor()
 {
+    stopTimer();
+
+    for (auto* param : getParameters()) {
+        if (auto* rangedParam = dynamic_cast<juce::RangedAudioParameter*>(param))
+            apvts.removeParameterListener(rangedParam->paramID, this);
+    }
 }
 
 //==============================================================================
@@ -70,7 +95,11 @@ bool KGP_EQAudioProcessor::isMidiEffect() const
 
 double KGP_EQAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    // The kernel covers the whole response in linear phase mode
+    if (isLinearPhase(parameterValues) && getSampleRate() > 0.0)
+        return linearPhaseFilter.getKernelLength() / getSampleRate();
+
+    return tailLengthSeconds.load();
 }
 
 int KGP_EQAudioProcessor::getNumPrograms()
@@ -103,24 +132,49 @@ void KGP_EQAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
 
-    juce::dsp::ProcessSpec spec;
+    auto numChannels = getTotalNumOutputChannels();
+
+    filterEngine.prepare(numChannels, samplesPerBlock * maxOversamplingFactor);
+
+    for (size_t i = 0; i < oversamplers.size(); i++) {
+        oversamplers[i] = std::make_unique<juce::dsp::Oversampling<float>>((size_t)numChannels, i + 1,
+            juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, true, true);
+        oversamplers[i]->initProcessing((size_t)samplesPerBlock);
+        oversamplerLatencies[i].store(juce::roundToInt(oversamplers[i]->getLatencyInSamples()));
+    }
 
-    spec.maximumBlockSize = samplesPerBlock;
-    spec.numChannels = 1;
-    spec.sampleRate = sampleRate;
+    linearPhaseActive = isLinearPhase(parameterValues);
+    activeOversamplingFactor = getOversamplingFactor(parameterValues);
 
-    lChain.prepare(spec);
-    rChain.prepare(spec);
+    // The audio thread isn't running yet, so design synchronously here and let the
+    // designer thread catch up with the new sample rate in the background. That covers
+    // a restored state as well.
+    stateRestorePending.store(false);
 
-    updateFilters();
+    auto chainSettings = getChainSettings(parameterValues);
+
+    CoefficientSet coefficientSet;
+    updateCoefficientSet(coefficientSet, chainSettings, getProcessingSampleRate(), allBandsMask);
+    updateFilters(coefficientSet, allBandsMask);
+
+    parameterSmoother.prepare(getProcessingSampleRate(), chainSettings);
+
+    // Prepared before the designer learns the new rate, so it never sees a stale kernel length
+    linearPhaseFilter.prepare({ sampleRate, (juce::uint32)samplesPerBlock, (juce::uint32)numChannels });
+    updateLatency();
+
+    tailSamplesRemaining = getActiveTailLengthInSamples();
+    filterStateFlushed = false;
+
+    coefficientDesigner.setSampleRate(getProcessingSampleRate());
+
+    loadMeasurer.reset(sampleRate, samplesPerBlock);
+    audioThreadMonitor.prepare(sampleRate);
 
     leftChannelFifo.prepare(samplesPerBlock);
     rightChannelFifo.prepare(samplesPerBlock);
-    osc.initialise([](float x) {return std::sin(x); });
 
-    spec.numChannels = getTotalNumOutputChannels();
-    osc.prepare(spec);
-    osc.setFrequency(440);
+    testSignalGenerator.prepare(sampleRate);
 }
 
 void KGP_EQAudioProcessor::releaseResources()
@@ -136,12 +190,10 @@ bool KGP_EQAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) c
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (//layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-        layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Any layout from mono up to 7.1.4. Every channel runs through the same bands, the
+    // engine packs channels into SIMD lanes so wide layouts cost a few lanes, not copies.
+    auto mainOutput = layouts.getMainOutputChannelSet();
+    if (mainOutput.isDisabled() || mainOutput.size() > maxNumChannels)
         return false;
 
     // This checks if the input layout matches the output layout
@@ -157,6 +209,8 @@ bool KGP_EQAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) c
 
 void KGP_EQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    AudioThreadMonitor::ScopedBlock monitoredBlock(audioThreadMonitor, buffer.getNumSamples());
+    juce::AudioProcessLoadMeasurer::ScopedTimer loadTimer(loadMeasurer, buffer.getNumSamples());
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -170,33 +224,220 @@ void KGP_EQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce:
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-    updateFilters();
+    // Each time a test signal is selected it starts from the beginning, so runs are repeatable
+    auto testSignal = static_cast<TestSignal>((int)parameterValues.testSignal->load());
+    if (testSignal != activeTestSignal) {
+        testSignalGenerator.reset();
+        activeTestSignal = testSignal;
+    }
+
+    if (testSignal != TestSignal::testSignalOff)
+        testSignalGenerator.process(testSignal, buffer);
+
+    // A restored state only marks the bands dirty once the host starts processing
+    if (stateRestorePending.exchange(false))
+        coefficientDesigner.markDirty(allBandsMask);
+
+    auto chainSettings = getChainSettings(parameterValues);
+    auto controlRate = getControlRateInSamples(parameterValues);
+
+    // Switching modes changes the latency, so neither engine's history is worth keeping
+    auto linearPhase = isLinearPhase(parameterValues);
+    if (linearPhase != linearPhaseActive) {
+        filterEngine.reset();
+        linearPhaseFilter.reset();
+        linearPhaseActive = linearPhase;
+    }
+
+    auto oversamplingFactor = getOversamplingFactor(parameterValues);
+    if (oversamplingFactor != activeOversamplingFactor)
+        setOversamplingFactor(oversamplingFactor, chainSettings);
+
+    // Fully bypassed, or silent for longer than the filters ring: the output is the input.
+    // Modes with latency keep running while bypassed, so the reported latency stays true.
+    auto allBandsBypassed = chainSettings.lowCutByPassed && chainSettings.peakByPassed && chainSettings.highCutByPassed
+                         && !hasActiveParametricBands(chainSettings);
+
+    auto inputIsSilent = isInputSilent(buffer);
+    if (!inputIsSilent)
+        tailSamplesRemaining = getActiveTailLengthInSamples();
+
+    auto skipFiltering = (allBandsBypassed && getLatencySamples() == 0) || (inputIsSilent && tailSamplesRemaining == 0);
+
+    // The convolution crossfades between kernels, so ramping only applies to the IIR engine
+    juce::uint32 rampingBands = 0;
+    if (controlRate > 0 && !skipFiltering && !linearPhase)
+        rampingBands = parameterSmoother.setTargetValues(chainSettings, buffer.getNumSamples() * activeOversamplingFactor);
+    else
+        parameterSmoother.setCurrentAndTargetValues(chainSettings);
+
+    if (auto* coefficientSet = coefficientDesigner.getLatestCoefficients()) {
+        if (coefficientSet->sampleRate == getProcessingSampleRate()) {
+            juce::uint32 bandsToUpdate = 0;
+            for (int band = 0; band < (int)appliedBandVersions.size(); band++) {
+                if (coefficientSet->bandVersions[band] != appliedBandVersions[band]) {
+                    bandsToUpdate |= 1u << band;
+                    appliedBandVersions[band] = coefficientSet->bandVersions[band];
+                }
+            }
+
+            // Ramping bands are designed below and end up on the same final values
+            updateFilters(*coefficientSet, bandsToUpdate & ~rampingBands);
+        }
+    }
 
     juce::dsp::AudioBlock<float> block(buffer);
 
-    auto lBlock = block.getSingleChannelBlock(0);
-    auto rBlock = block.getSingleChannelBlock(1);
+    if (skipFiltering) {
+        // Whatever is left in the state has decayed below audibility (or is being
+        // bypassed), so start from silence once processing resumes
+        if (!filterStateFlushed) {
+            filterEngine.reset();
+            linearPhaseFilter.reset();
 
-    juce::dsp::ProcessContextReplacing<float> leftContext(lBlock);
-    juce::dsp::ProcessContextReplacing<float> rightContext(rBlock);
+            if (auto* oversampler = getActiveOversampler())
+                oversampler->reset();
 
-    lChain.process(leftContext);
-    rChain.process(rightContext);
+            filterStateFlushed = true;
+        }
+    }
+    else if (auto* oversampler = getActiveOversampler()) {
+        auto oversampledBlock = oversampler->processSamplesUp(block);
+        processFilters(oversampledBlock, chainSettings, rampingBands, controlRate);
+        oversampler->processSamplesDown(block);
+    }
+    else {
+        processFilters(block, chainSettings, rampingBands, controlRate);
+    }
+
+    if (!skipFiltering) {
+        filterStateFlushed = false;
+
+        if (inputIsSilent)
+            tailSamplesRemaining = juce::jmax(0, tailSamplesRemaining - buffer.getNumSamples());
+    }
 
-    leftChannelFifo.update(buffer);
-    rightChannelFifo.update(buffer);
+    if (analyzerConsumers.load() == allAnalyzerConsumerBits) {
+        leftChannelFifo.update(buffer);
+        rightChannelFifo.update(buffer);
+    }
+}
+
+void KGP_EQAudioProcessor::processFilters(juce::dsp::AudioBlock<float>& block, const ChainSettings& chainSettings,
+                                          juce::uint32 rampingBands, int controlRate) {
+    if (linearPhaseActive) {
+        // Latency stays at 0 until the first kernel has been swapped in; the timer reports it
+        if (linearPhaseFilter.process(block))
+            latencyUpdatePending.store(true);
+
+        return;
+    }
+
+    if (rampingBands == 0) {
+        filterEngine.process(block);
+        return;
+    }
+
+    const auto numSamples = (int)block.getNumSamples();
+
+    for (int start = 0; start < numSamples; start += controlRate) {
+        auto numToProcess = juce::jmin(controlRate, numSamples - start);
+
+        auto smoothedSettings = chainSettings;
+        parameterSmoother.skip(numToProcess, smoothedSettings);
+
+        updateCoefficientSet(smoothedCoefficients, smoothedSettings, getProcessingSampleRate(), rampingBands);
+        updateFilters(smoothedCoefficients, rampingBands);
+
+        auto subBlock = block.getSubBlock((size_t)start, (size_t)numToProcess);
+        filterEngine.process(subBlock);
+    }
+}
+
+juce::dsp::Oversampling<float>* KGP_EQAudioProcessor::getActiveOversampler() const {
+    switch (activeOversamplingFactor) {
+    case 2:
+        return oversamplers[0].get();
+    case 4:
+        return oversamplers[1].get();
+    default:
+        return nullptr;
+    }
+}
+
+void KGP_EQAudioProcessor::setOversamplingFactor(int factor, const ChainSettings& chainSettings) {
+    activeOversamplingFactor = factor;
+
+    if (auto* oversampler = getActiveOversampler())
+        oversampler->reset();
+
+    filterEngine.reset();
+
+    // The designs are allocation free, and the designer thread catches up with the new rate later
+    updateCoefficientSet(smoothedCoefficients, chainSettings, getProcessingSampleRate(), allBandsMask);
+    updateFilters(smoothedCoefficients, allBandsMask);
+
+    parameterSmoother.prepare(getProcessingSampleRate(), chainSettings);
+}
+
+bool KGP_EQAudioProcessor::isInputSilent(const juce::AudioBuffer<float>& buffer) const {
+    for (int channel = 0; channel < getTotalNumInputChannels(); channel++) {
+        if (buffer.getMagnitude(channel, 0, buffer.getNumSamples()) > silenceThreshold)
+            return false;
+    }
+
+    return true;
+}
+
+int KGP_EQAudioProcessor::getActiveTailLengthInSamples() const {
+    if (linearPhaseActive)
+        return linearPhaseFilter.getKernelLength();
+
+    // The engine's tail is counted at the oversampled rate
+    auto tail = filterEngine.getTailLengthInSamples();
+    return (tail + activeOversamplingFactor - 1) / activeOversamplingFactor + getLatencySamples();
+}
+
+void KGP_EQAudioProcessor::updateLatency() {
+    if (isLinearPhase(parameterValues)) {
+        setLatencySamples(linearPhaseFilter.getLatencyInSamples());
+        return;
+    }
+
+    auto factor = getOversamplingFactor(parameterValues);
+    setLatencySamples(factor > 1 ? oversamplerLatencies[factor == 4 ? 1 : 0].load() : 0);
+}
+
+void KGP_EQAudioProcessor::requestLatencyUpdate() {
+    if (juce::MessageManager::existsAndIsCurrentThread())
+        updateLatency();
+    else
+        latencyUpdatePending.store(true);
+}
+
+void KGP_EQAudioProcessor::timerCallback() {
+    if (latencyUpdatePending.exchange(false))
+        updateLatency();
 }
 
 //==============================================================================
 bool KGP_EQAudioProcessor::hasEditor() const
 {
+   #if KGP_EQ_HEADLESS
+    return false;
+   #else
     return true; // (change this to false if you choose to not supply an editor)
+   #endif
 }
 
 juce::AudioProcessorEditor* KGP_EQAudioProcessor::createEditor()
 {
+   #if KGP_EQ_HEADLESS
+    return nullptr;
+   #else
     return new KGP_EQAudioProcessorEditor (*this);
 //    return new juce::GenericAudioProcessorEditor(*this);
+   #endif
 }
 
 //==============================================================================
@@ -206,92 +447,493 @@ void KGP_EQAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
     // You could do that either as raw data, or use the XML or ValueTree classes
     // as intermediaries to make it easy to save and load complex data.
 
-    juce::MemoryOutputStream mos(destData, true);
-    apvts.state.writeToStream(mos);
+    writeBinaryState(getParameters(), destData);
 }
 
 void KGP_EQAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
     // You should use this method to restore your parameters from this memory block,
     // whose contents will have been created by the getStateInformation() call.
-    
-    auto tree = juce::ValueTree::readFromData(data, sizeInBytes);
-    if (tree.isValid()) {
-        apvts.replaceState(tree);
-        updateFilters();
+
+    auto linearPhase = isLinearPhase(parameterValues);
+    auto oversamplingFactor = getOversamplingFactor(parameterValues);
+
+    // Every restored parameter would mark its band dirty and wake the designer, so the
+    // bands are redesigned once, by the next prepareToPlay() or processBlock()
+    restoringState.store(true);
+
+    if (isBinaryState(data, sizeInBytes)) {
+        if (!readBinaryState(getParameters(), data, sizeInBytes)) {
+            // Truncated, or written by a newer build; defaults beat a half-restored session
+            jassertfalse;
+
+            for (auto* parameter : getParameters()) {
+                if (parameter->getValue() != parameter->getDefaultValue())
+                    parameter->setValueNotifyingHost(parameter->getDefaultValue());
+            }
+        }
     }
+    else {
+        // Sessions saved before the binary format
+        auto tree = juce::ValueTree::readFromData(data, sizeInBytes);
+        if (tree.isValid())
+            apvts.replaceState(tree);
+    }
+
+    restoringState.store(false);
+    stateRestorePending.store(true);
+
+    setAnalyzerConsumer(analyzerEnabledBit, apvts.getRawParameterValue("Analyzer Enabled")->load() > 0.5f);
+
+    // These change the latency; the host hears about it on the message thread
+    if (isLinearPhase(parameterValues) != linearPhase || getOversamplingFactor(parameterValues) != oversamplingFactor) {
+        requestLatencyUpdate();
+        coefficientDesigner.setSampleRate(getSampleRate() * getOversamplingFactor(parameterValues));
+    }
+}
+
+void KGP_EQAudioProcessor::parameterChanged(const juce::String& parameterID, float newValue) {
+    if (restoringState.load())
+        return;
+
+    if (parameterID == "Analyzer Enabled") {
+        setAnalyzerConsumer(analyzerEnabledBit, newValue > 0.5f);
+        return;
+    }
+
+    // Both change the processing rate. The kernel is only kept up to date while it is in use,
+    // and the rate change makes the designer redesign everything, including the kernel.
+    // Automation may arrive on the audio thread, which only flags the latency for the timer.
+    if (parameterID == "Phase Mode" || parameterID == "Oversampling") {
+        requestLatencyUpdate();
+        coefficientDesigner.setSampleRate(getSampleRate() * getOversamplingFactor(parameterValues));
+        return;
+    }
+
+    auto mask = getBandMaskForParameter(parameterID);
+    if (mask != 0)
+        coefficientDesigner.markDirty(mask);
+}
+
+void KGP_EQAudioProcessor::setAnalyzerConsumer(juce::uint32 bit, bool isConsuming) {
+    if (isConsuming)
+        analyzerConsumers.fetch_or(bit);
+    else
+        analyzerConsumers.fetch_and(~bit);
 }
 
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts) {
+juce::uint32 getBandMaskForParameter(const juce::String& parameterID) {
+    // The parametric bank's bells use the same design as the peak band
+    if (parameterID == "Peak Design")
+        return bandMask(ChainPositions::Peak) | bandMask(ChainPositions::Parametric);
+
+    if (parameterID.startsWith("Low-Cut"))
+        return bandMask(ChainPositions::LowCut);
+
+    if (parameterID.startsWith("Peak"))
+        return bandMask(ChainPositions::Peak);
+
+    if (parameterID.startsWith("High-Cut"))
+        return bandMask(ChainPositions::HighCut);
+
+    // The bank is redesigned as a whole, it's only a handful of biquads
+    if (parameterID.startsWith("Band "))
+        return bandMask(ChainPositions::Parametric);
+
+    return 0;
+}
+
+const ParametricBandParameterIDs& getParametricBandParameterIDs(int band) {
+    static const auto ids = []() {
+        std::array<ParametricBandParameterIDs, maxParametricBands> table;
+
+        for (int i = 0; i < maxParametricBands; i++) {
+            auto prefix = "Band " + juce::String(i + 1);
+            table[(size_t)i] = { prefix, prefix + " Frequency", prefix + " Gain", prefix + " Quality",
+                                 prefix + " Type", prefix + " Bypassed" };
+        }
+
+        return table;
+    }();
+
+    jassert(juce::isPositiveAndBelow(band, maxParametricBands));
+    return ids[(size_t)band];
+}
+
+bool hasActiveParametricBands(const ChainSettings& chainSettings) {
+    for (auto& band : chainSettings.parametricBands) {
+        if (!band.byPassed)
+            return true;
+    }
+
+    return false;
+}
+
+RawParameterValues::RawParameterValues(juce::AudioProcessorValueTreeState& apvts) :
+    lowCutFrequency(apvts.getRawParameterValue("Low-Cut Frequency")),
+    highCutFrequency(apvts.getRawParameterValue("High-Cut Frequency")),
+    lowCutSlope(apvts.getRawParameterValue("Low-Cut Slope")),
+    highCutSlope(apvts.getRawParameterValue("High-Cut Slope")),
+    peakFrequency(apvts.getRawParameterValue("Peak Frequency")),
+    peakGain(apvts.getRawParameterValue("Peak Gain")),
+    peakQuality(apvts.getRawParameterValue("Peak Quality")),
+    lowCutByPassed(apvts.getRawParameterValue("Low-Cut Bypassed")),
+    peakByPassed(apvts.getRawParameterValue("Peak Bypassed")),
+    highCutByPassed(apvts.getRawParameterValue("High-Cut Bypassed")),
+    lowCutTopology(apvts.getRawParameterValue("Low-Cut Topology")),
+    peakTopology(apvts.getRawParameterValue("Peak Topology")),
+    highCutTopology(apvts.getRawParameterValue("High-Cut Topology")),
+    peakDesign(apvts.getRawParameterValue("Peak Design")),
+    phaseMode(apvts.getRawParameterValue("Phase Mode")),
+    oversampling(apvts.getRawParameterValue("Oversampling")),
+    controlRate(apvts.getRawParameterValue("Control Rate")),
+    testSignal(apvts.getRawParameterValue("Test Signal"))
+{
+    for (int i = 0; i < maxParametricBands; i++) {
+        const auto& ids = getParametricBandParameterIDs(i);
+        parametricBands[(size_t)i] = { apvts.getRawParameterValue(ids.frequency), apvts.getRawParameterValue(ids.gain),
+                                       apvts.getRawParameterValue(ids.quality), apvts.getRawParameterValue(ids.type),
+                                       apvts.getRawParameterValue(ids.byPassed) };
+    }
+}
+
+ChainSettings getChainSettings(const RawParameterValues& parameters) {
     ChainSettings settings;
 
-    settings.lowCutFrequency = apvts.getRawParameterValue("Low-Cut Frequency")->load();
-    settings.highCutFrequency = apvts.getRawParameterValue("High-Cut Frequency")->load();
-    settings.lowCutSlope = static_cast<Slope>( apvts.getRawParameterValue("Low-Cut Slope")->load() );
-    settings.highCutSlope = static_cast<Slope>( apvts.getRawParameterValue("High-Cut Slope")->load() );
-    settings.peakFreq = apvts.getRawParameterValue("Peak Frequency")->load();
-    settings.peakGainInDB = apvts.getRawParameterValue("Peak Gain")->load();
-    settings.peakQuality = apvts.getRawParameterValue("Peak Quality")->load();
+    settings.lowCutFrequency = parameters.lowCutFrequency->load();
+    settings.highCutFrequency = parameters.highCutFrequency->load();
+    settings.lowCutSlope = static_cast<Slope>( parameters.lowCutSlope->load() );
+    settings.highCutSlope = static_cast<Slope>( parameters.highCutSlope->load() );
+    settings.peakFreq = parameters.peakFrequency->load();
+    settings.peakGainInDB = parameters.peakGain->load();
+    settings.peakQuality = parameters.peakQuality->load();
+
+    settings.lowCutByPassed = parameters.lowCutByPassed->load() > 0.5f;
+    settings.peakByPassed = parameters.peakByPassed->load() > 0.5f;
+    settings.highCutByPassed = parameters.highCutByPassed->load() > 0.5f;
+
+    settings.lowCutTopology = static_cast<FilterTopology>( parameters.lowCutTopology->load() );
+    settings.peakTopology = static_cast<FilterTopology>( parameters.peakTopology->load() );
+    settings.highCutTopology = static_cast<FilterTopology>( parameters.highCutTopology->load() );
+
+    settings.peakDesign = static_cast<PeakDesign>( parameters.peakDesign->load() );
+
+    for (int i = 0; i < maxParametricBands; i++) {
+        const auto& values = parameters.parametricBands[(size_t)i];
+        auto& band = settings.parametricBands[(size_t)i];
 
-    settings.lowCutByPassed = apvts.getRawParameterValue("Low-Cut Bypassed")->load() > 0.5f;
-    settings.peakByPassed = apvts.getRawParameterValue("Peak Bypassed")->load() > 0.5f;
-    settings.highCutByPassed = apvts.getRawParameterValue("High-Cut Bypassed")->load() > 0.5f;
+        band.byPassed = values.byPassed->load() > 0.5f;
+        if (band.byPassed)
+            continue;
+
+        band.frequency = values.frequency->load();
+        band.gainInDB = values.gain->load();
+        band.quality = values.quality->load();
+        band.type = static_cast<ParametricBandType>( values.type->load() );
+    }
 
     return settings;
 }
 
-Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate) {
-    return juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate, chainSettings.peakFreq, chainSettings.peakQuality, juce::Decibels::decibelsToGain(chainSettings.peakGainInDB));
+void KGP_EQAudioProcessor::updateFilters(const CoefficientSet& coefficientSet, juce::uint32 bandsToUpdate) {
+    if (bandsToUpdate & bandMask(ChainPositions::LowCut))
+        filterEngine.setLowCut(coefficientSet.lowCut, coefficientSet.lowCutTopology, coefficientSet.lowCutByPassed);
+
+    if (bandsToUpdate & bandMask(ChainPositions::Peak))
+        filterEngine.setPeak(coefficientSet.peak, coefficientSet.peakTopology, coefficientSet.peakByPassed);
+
+    if (bandsToUpdate & bandMask(ChainPositions::HighCut))
+        filterEngine.setHighCut(coefficientSet.highCut, coefficientSet.highCutTopology, coefficientSet.highCutByPassed);
+
+    if (bandsToUpdate & bandMask(ChainPositions::Parametric))
+        filterEngine.setParametricBands(coefficientSet.parametric);
+
+    if (bandsToUpdate != 0 && coefficientSet.sampleRate > 0.0)
+        tailLengthSeconds.store(filterEngine.getTailLengthInSamples() / coefficientSet.sampleRate);
+}
+
+void updateCoefficientSet(CoefficientSet& set, const ChainSettings& chainSettings, double sampleRate, juce::uint32 bandsToUpdate) {
+    if (bandsToUpdate & bandMask(ChainPositions::LowCut)) {
+        set.lowCut = designButterworthHighPass(sampleRate, chainSettings.lowCutFrequency, 2 * (chainSettings.lowCutSlope + 1));
+        set.lowCutTopology = chainSettings.lowCutTopology;
+        set.lowCutByPassed = chainSettings.lowCutByPassed;
+        set.bandVersions[ChainPositions::LowCut]++;
+    }
+
+    if (bandsToUpdate & bandMask(ChainPositions::Peak)) {
+        auto gainFactor = juce::Decibels::decibelsToGain(chainSettings.peakGainInDB);
+
+        if (chainSettings.peakDesign == PeakDesign::matchedPeak)
+            set.peak = designMatchedPeak(sampleRate, chainSettings.peakFreq, chainSettings.peakQuality, gainFactor);
+        else
+            set.peak = designPeak(sampleRate, chainSettings.peakFreq, chainSettings.peakQuality, gainFactor);
+        set.peakTopology = chainSettings.peakTopology;
+        set.peakByPassed = chainSettings.peakByPassed;
+        set.bandVersions[ChainPositions::Peak]++;
+    }
+
+    if (bandsToUpdate & bandMask(ChainPositions::HighCut)) {
+        set.highCut = designButterworthLowPass(sampleRate, chainSettings.highCutFrequency, 2 * (chainSettings.highCutSlope + 1));
+        set.highCutTopology = chainSettings.highCutTopology;
+        set.highCutByPassed = chainSettings.highCutByPassed;
+        set.bandVersions[ChainPositions::HighCut]++;
+    }
+
+    if (bandsToUpdate & bandMask(ChainPositions::Parametric)) {
+        auto& parametric = set.parametric;
+        parametric.numActive = 0;
+
+        for (int i = 0; i < maxParametricBands; i++) {
+            const auto& band = chainSettings.parametricBands[(size_t)i];
+            if (band.byPassed)
+                continue;
+
+            parametric.sections[(size_t)parametric.numActive] = designParametricBand(band, chainSettings.peakDesign, sampleRate);
+            parametric.bandIndices[(size_t)parametric.numActive] = i;
+            parametric.numActive++;
+        }
+
+        set.bandVersions[ChainPositions::Parametric]++;
+    }
+
+    set.sampleRate = sampleRate;
+}
+
+BiquadCoefficients designParametricBand(const ParametricBandSettings& band, PeakDesign peakDesign, double sampleRate) {
+    auto gainFactor = juce::Decibels::decibelsToGain((double)band.gainInDB);
+
+    switch (band.type) {
+    case ParametricBandType::lowShelfBandType:
+        return designLowShelfBiquad(sampleRate, band.frequency, band.quality, gainFactor);
+    case ParametricBandType::highShelfBandType:
+        return designHighShelfBiquad(sampleRate, band.frequency, band.quality, gainFactor);
+    case ParametricBandType::notchBandType:
+        return designNotchBiquad(sampleRate, band.frequency, band.quality);
+    case ParametricBandType::peakBandType:
+    default:
+        if (peakDesign == PeakDesign::matchedPeak)
+            return designMatchedPeakBiquad(sampleRate, band.frequency, band.quality, gainFactor);
+
+        return designPeakBiquad(sampleRate, band.frequency, band.quality, gainFactor);
+    }
+}
+
+namespace {
+    // SmoothedValue::reset(numSteps) jumps to the target, so keep the current value explicitly
+    template<typename SmoothedValueType>
+    void changeRampLength(SmoothedValueType& value, int numSteps) {
+        auto current = value.getCurrentValue();
+        auto target = value.getTargetValue();
+
+        value.reset(numSteps);
+        value.setCurrentAndTargetValue(current);
+        value.setTargetValue(target);
+    }
+}
+
+void ParameterSmoother::prepare(double sampleRate, const ChainSettings& chainSettings) {
+    minimumRampLength = juce::jmax(1, (int)std::floor(sampleRate * rampLengthSeconds));
+    rampLength = 0;
+
+    setRampLength(minimumRampLength);
+    setCurrentAndTargetValues(chainSettings);
+}
+
+void ParameterSmoother::setRampLength(int numSamples) {
+    if (numSamples == rampLength)
+        return;
+
+    changeRampLength(lowCutFrequency, numSamples);
+    changeRampLength(highCutFrequency, numSamples);
+    changeRampLength(peakFrequency, numSamples);
+    changeRampLength(peakQuality, numSamples);
+    changeRampLength(peakGainInDB, numSamples);
+
+    for (auto& band : parametricBands) {
+        changeRampLength(band.frequency, numSamples);
+        changeRampLength(band.quality, numSamples);
+        changeRampLength(band.gainInDB, numSamples);
+    }
+
+    rampLength = numSamples;
+}
+
+void ParameterSmoother::setCurrentAndTargetValues(const ChainSettings& chainSettings) {
+    lowCutFrequency.setCurrentAndTargetValue(chainSettings.lowCutFrequency);
+    highCutFrequency.setCurrentAndTargetValue(chainSettings.highCutFrequency);
+    peakFrequency.setCurrentAndTargetValue(chainSettings.peakFreq);
+    peakQuality.setCurrentAndTargetValue(chainSettings.peakQuality);
+    peakGainInDB.setCurrentAndTargetValue(chainSettings.peakGainInDB);
+
+    for (size_t i = 0; i < parametricBands.size(); i++) {
+        const auto& settings = chainSettings.parametricBands[i];
+        auto& band = parametricBands[i];
+
+        band.active = !settings.byPassed;
+        if (!band.active)
+            continue;
+
+        band.frequency.setCurrentAndTargetValue(settings.frequency);
+        band.quality.setCurrentAndTargetValue(settings.quality);
+        band.gainInDB.setCurrentAndTargetValue(settings.gainInDB);
+    }
+}
+
+juce::uint32 ParameterSmoother::setTargetValues(const ChainSettings& chainSettings, int numSamplesInBlock) {
+    setRampLength(juce::jmax(minimumRampLength, numSamplesInBlock));
+
+    lowCutFrequency.setTargetValue(chainSettings.lowCutFrequency);
+    highCutFrequency.setTargetValue(chainSettings.highCutFrequency);
+    peakFrequency.setTargetValue(chainSettings.peakFreq);
+    peakQuality.setTargetValue(chainSettings.peakQuality);
+    peakGainInDB.setTargetValue(chainSettings.peakGainInDB);
+
+    bool parametricRamping = false;
+
+    for (size_t i = 0; i < parametricBands.size(); i++) {
+        const auto& settings = chainSettings.parametricBands[i];
+        auto& band = parametricBands[i];
+
+        if (settings.byPassed) {
+            band.active = false;
+            continue;
+        }
+
+        if (!band.active) {
+            band.active = true;
+            band.frequency.setCurrentAndTargetValue(settings.frequency);
+            band.quality.setCurrentAndTargetValue(settings.quality);
+            band.gainInDB.setCurrentAndTargetValue(settings.gainInDB);
+            continue;
+        }
+
+        band.frequency.setTargetValue(settings.frequency);
+        band.quality.setTargetValue(settings.quality);
+        band.gainInDB.setTargetValue(settings.gainInDB);
+
+        parametricRamping = parametricRamping || band.frequency.isSmoothing() || band.quality.isSmoothing() || band.gainInDB.isSmoothing();
+    }
+
+    juce::uint32 rampingBands = 0;
+
+    if (lowCutFrequency.isSmoothing())
+        rampingBands |= bandMask(ChainPositions::LowCut);
+
+    if (peakFrequency.isSmoothing() || peakQuality.isSmoothing() || peakGainInDB.isSmoothing())
+        rampingBands |= bandMask(ChainPositions::Peak);
+
+    if (highCutFrequency.isSmoothing())
+        rampingBands |= bandMask(ChainPositions::HighCut);
+
+    if (parametricRamping)
+        rampingBands |= bandMask(ChainPositions::Parametric);
+
+    return rampingBands;
 }
 
+void ParameterSmoother::skip(int numSamples, ChainSettings& chainSettings) {
+    chainSettings.lowCutFrequency = lowCutFrequency.skip(numSamples);
+    chainSettings.highCutFrequency = highCutFrequency.skip(numSamples);
+    chainSettings.peakFreq = peakFrequency.skip(numSamples);
+    chainSettings.peakQuality = peakQuality.skip(numSamples);
+    chainSettings.peakGainInDB = peakGainInDB.skip(numSamples);
+
+    for (size_t i = 0; i < parametricBands.size(); i++) {
+        auto& band = parametricBands[i];
+        if (!band.active)
+            continue;
+
+        auto& settings = chainSettings.parametricBands[i];
+        settings.frequency = band.frequency.skip(numSamples);
+        settings.quality = band.quality.skip(numSamples);
+        settings.gainInDB = band.gainInDB.skip(numSamples);
+    }
+}
 
-void KGP_EQAudioProcessor::updatePeakFilter(const ChainSettings& chainSettings) {
-    auto peakCoefficients = makePeakFilter(chainSettings, getSampleRate());
+bool isLinearPhase(const RawParameterValues& parameters) {
+    return parameters.phaseMode->load() > 0.5f;
+}
 
-    lChain.setBypassed<ChainPositions::Peak>(chainSettings.peakByPassed);
-    rChain.setBypassed<ChainPositions::Peak>(chainSettings.peakByPassed);
+int getOversamplingFactor(const RawParameterValues& parameters) {
+    if (isLinearPhase(parameters))
+        return 1;
 
-    updateCoefficients(lChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
-    updateCoefficients(rChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
+    auto index = juce::jlimit(0, 2, (int)parameters.oversampling->load());
+    return 1 << index;
 }
 
-void updateCoefficients(Coefficients& old, const Coefficients& new_) {
-    *old = *new_;
+int getControlRateInSamples(const RawParameterValues& parameters) {
+    static constexpr int controlRates[] = { 0, 16, 32, 64 };
+
+    auto index = juce::jlimit(0, 3, (int)parameters.controlRate->load());
+    return controlRates[index];
 }
 
+CoefficientDesigner::CoefficientDesigner(const RawParameterValues& parameterValues, LinearPhaseFilter& filter) :
+    juce::Thread("KGP_EQ Coefficient Designer"),
+    parameters(parameterValues),
+    linearPhaseFilter(filter)
+{
+}
 
-void KGP_EQAudioProcessor::updateLowCutFilter(const ChainSettings& chainSettings) {
-    auto lowCutCoefficients = juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(chainSettings.lowCutFrequency, getSampleRate(), 2 * (chainSettings.lowCutSlope + 1));
-    
-    auto& leftLowCut = lChain.get<ChainPositions::LowCut>();
-    auto& rightLowCut = rChain.get<ChainPositions::LowCut>();
+CoefficientDesigner::~CoefficientDesigner() {
+    stopThread(1000);
+}
 
-    lChain.setBypassed<ChainPositions::LowCut>(chainSettings.lowCutByPassed);
-    rChain.setBypassed<ChainPositions::LowCut>(chainSettings.lowCutByPassed);
+void CoefficientDesigner::setSampleRate(double newSampleRate) {
+    sampleRate.store(newSampleRate);
+    markDirty(allBandsMask);
+}
 
-    UpdateCutFilter(leftLowCut, lowCutCoefficients, chainSettings.lowCutSlope);
-    UpdateCutFilter(rightLowCut, lowCutCoefficients, chainSettings.lowCutSlope);
+void CoefficientDesigner::markDirty(juce::uint32 bands) {
+    dirtyBands.fetch_or(bands);
+    notify();
 }
 
-void KGP_EQAudioProcessor::updateHighCutFilter(const ChainSettings& chainSettings) {
-    auto highCutCoefficients = juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(chainSettings.highCutFrequency, getSampleRate(), 2 * (chainSettings.highCutSlope + 1));
+void CoefficientDesigner::run() {
+    while (!threadShouldExit()) {
+        wait(-1);
 
-    auto& leftHighCut = lChain.get<ChainPositions::HighCut>();
-    auto& rightHighCut = rChain.get<ChainPositions::HighCut>();
+        if (threadShouldExit())
+            return;
 
-    lChain.setBypassed<ChainPositions::HighCut>(chainSettings.highCutByPassed);
-    rChain.setBypassed<ChainPositions::HighCut>(chainSettings.highCutByPassed);
+        auto currentSampleRate = sampleRate.load();
+        if (currentSampleRate <= 0.0)
+            continue;
 
-    UpdateCutFilter(leftHighCut, highCutCoefficients, chainSettings.highCutSlope);
-    UpdateCutFilter(rightHighCut, highCutCoefficients, chainSettings.highCutSlope);
+        auto bandsToUpdate = dirtyBands.exchange(0);
+        if (bandsToUpdate == 0)
+            continue;
+
+        // A sample rate change invalidates every band, not just the dirty ones
+        if (staging.sampleRate != currentSampleRate)
+            bandsToUpdate = allBandsMask;
+
+        updateCoefficientSet(staging, getChainSettings(parameters), currentSampleRate, bandsToUpdate);
+
+        coefficientSets.getWriteBuffer() = staging;
+        coefficientSets.publish();
+
+        if (isLinearPhase(parameters))
+            designKernel(staging);
+    }
 }
 
-void KGP_EQAudioProcessor::updateFilters() {
-    auto chainSettings = getChainSettings(apvts);
+void CoefficientDesigner::designKernel(const CoefficientSet& coefficientSet) {
+    kernelDesigner.prepare(coefficientSet.sampleRate);
+
+    if (!coefficientSet.lowCutByPassed)
+        kernelDesigner.addBand(coefficientSet.lowCut);
+
+    if (!coefficientSet.peakByPassed)
+        kernelDesigner.addBand(coefficientSet.peak);
 
-    updateLowCutFilter(chainSettings);
-    updatePeakFilter(chainSettings);
-    updateHighCutFilter(chainSettings);
+    if (!coefficientSet.highCutByPassed)
+        kernelDesigner.addBand(coefficientSet.highCut);
+
+    kernelDesigner.addSections(coefficientSet.parametric.sections.data(), coefficientSet.parametric.numActive);
+
+    linearPhaseFilter.loadKernel(kernelDesigner.createKernel(), coefficientSet.sampleRate);
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout
@@ -335,6 +977,64 @@ KGP_EQAudioProcessor::createParameterLayout()
     layout.add(std::make_unique<juce::AudioParameterBool>("High-Cut Bypassed", "High-Cut Bypassed", false));
     layout.add(std::make_unique<juce::AudioParameterBool>("Analyzer Enabled", "Analyzer Enabled", true));
 
+    // Double precision state keeps very low cutoffs at high sample rates stable, at some extra cost
+    juce::StringArray topologies{ "TDF-II (float)", "TDF-II (double)", "SVF (double)" };
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Low-Cut Topology", "Low-Cut Topology", topologies, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Peak Topology", "Peak Topology", topologies, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("High-Cut Topology", "High-Cut Topology", topologies, 0));
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Analyzer Overlap", "Analyzer Overlap",
+        juce::StringArray{ "One Per Frame", "50%", "75%" }, 0));
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Analyzer Resolution", "Analyzer Resolution",
+        juce::StringArray{ "2048", "4096", "8192" }, 0));
+
+    // Coefficient update interval while frequency, gain or Q are ramping
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Control Rate", "Control Rate",
+        juce::StringArray{ "Off", "16 Samples", "32 Samples", "64 Samples" }, 2));
+
+    // Replaces the input, for measurements without a signal generator in the host
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Test Signal", "Test Signal",
+        juce::StringArray{ "Off", "Sine Sweep", "Pink Noise", "Impulse" }, 0));
+
+    // Falls back to Software when OpenGL isn't compiled in or the context can't be created
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Analyzer Renderer", "Analyzer Renderer",
+        juce::StringArray{ "Software", "OpenGL" }, 0));
+
+    // Linear phase trades a quarter of a second or more of latency for no phase shift
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Phase Mode", "Phase Mode",
+        juce::StringArray{ "Minimum Phase", "Linear Phase" }, 0));
+
+    // Runs the IIR bands at a multiple of the host rate, so bells and the high cut keep
+    // their analog shape near Nyquist
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Oversampling", "Oversampling",
+        juce::StringArray{ "Off", "2x", "4x" }, 0));
+
+    // The matched design gets most of that accuracy for the peak without oversampling
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Peak Design", "Peak Design",
+        juce::StringArray{ "Bilinear", "Matched" }, 0));
+
+    // Extra bands, all bypassed by default and spread evenly over the spectrum
+    for (int i = 0; i < maxParametricBands; i++) {
+        const auto& ids = getParametricBandParameterIDs(i);
+        auto defaultFrequency = (float)juce::mapToLog10((i + 0.5) / maxParametricBands, 20.0, 20000.0);
+
+        layout.add(std::make_unique<juce::AudioParameterFloat>(ids.frequency, ids.frequency,
+            juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.2f), std::round(defaultFrequency)));
+
+        layout.add(std::make_unique<juce::AudioParameterFloat>(ids.gain, ids.gain,
+            juce::NormalisableRange<float>(-30.f, 30.f, 0.5f, 1.f), 0.0f));
+
+        layout.add(std::make_unique<juce::AudioParameterFloat>(ids.quality, ids.quality,
+            juce::NormalisableRange<float>(0.1f, 10.f, 0.05f, 1.f), 1.f));
+
+        layout.add(std::make_unique<juce::AudioParameterChoice>(ids.type, ids.type,
+            juce::StringArray{ "Peak", "Low Shelf", "High Shelf", "Notch" }, 0));
+
+        layout.add(std::make_unique<juce::AudioParameterBool>(ids.byPassed, ids.byPassed, true));
+    }
+
         return layout;
 }
 
@@ -17,9 +17,19 @@
 
 #include <JuceHeader.h>
 #include <array>
-
-template<typename T>
+#include <atomic>
+#include "AudioThreadMonitor.h"
+#include "CoefficientDesign.h"
+#include "FilterEngine.h"
+#include "LinearPhaseFilter.h"
+#include "TestSignalGenerator.h"
+
+// Sized by the caller for how far the consumer can fall behind. AbstractFifo keeps one
+// slot free, so a Fifo holds at most Capacity - 1 items.
+template<typename T, int Capacity>
 struct Fifo {
+    static_assert(Capacity >= 2, "A Fifo needs at least two slots to hold anything");
+
     void prepare(int numChannels, int numSamples) {
         static_assert(std::is_same_v<T, juce::AudioBuffer<float>>,
             "prepare(numChannels, numSamples) should only be used when Fifo is holding juce::AudioBuffer<float>");
@@ -63,74 +73,111 @@ struct Fifo {
     }
 
 private:
-    static constexpr int Capacity = 30;
     std::array<T, Capacity> buffers;
     juce::AbstractFifo fifo{ Capacity };
 };
 
+// Wait-free single-producer/single-consumer handoff of the most recently published T.
+// The three slots are recycled in place, so neither side ever allocates or frees.
+template<typename T>
+struct TripleBuffer {
+    T& getWriteBuffer() { return buffers[writeIndex]; }
+
+    void publish() {
+        auto previous = shared.exchange(writeIndex | newDataFlag, std::memory_order_acq_rel);
+        writeIndex = previous & indexMask;
+    }
+
+    // Returns nullptr if nothing was published since the last call
+    const T* acquire() {
+        if ((shared.load(std::memory_order_acquire) & newDataFlag) == 0)
+            return nullptr;
+
+        auto previous = shared.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & indexMask;
+        return &buffers[readIndex];
+    }
+
+private:
+    static constexpr int indexMask = 3;
+    static constexpr int newDataFlag = 4;
+
+    std::array<T, 3> buffers;
+    std::atomic<int> shared{ 1 };
+    int writeIndex = 0, readIndex = 2;
+};
+
 enum Channel {
     Right,
     Left
 };
 
+// Single-producer/single-consumer ring of samples from one channel. The audio thread
+// pushes whole blocks in at most two copies; the GUI reads contiguous spans in place.
+// The ring is allocated once, at its full size, because the analyzer job may be inside
+// read() on a pool thread whenever prepareToPlay() runs.
 template<typename BlockType>
 struct SingleChannelSampleFifo {
-    SingleChannelSampleFifo(Channel ch) : channelToUse(ch) {
+    SingleChannelSampleFifo(Channel ch) : channelToUse(ch), samples((size_t)capacity, 0.f) {
         prepared.set(false);
     }
 
     void update(const BlockType& buffer) {
         jassert(prepared.get());
-        jassert(buffer.getNumChannels() > channelToUse);
+        jassert(buffer.getNumChannels() > 0);
 
-        auto* channelPtr = buffer.getReadPointer(channelToUse);
+        // Mono layouts feed the same channel to both analyzer traces
+        auto* channelPtr = buffer.getReadPointer(juce::jmin((int)channelToUse, buffer.getNumChannels() - 1));
 
-        for (int i = 0; i < buffer.getNumSamples(); i++) {
-            pushNextSampleIntoFifo(channelPtr[i]);
-        }
+        // If the reader has fallen behind, the samples that don't fit are dropped
+        auto write = fifo.write(buffer.getNumSamples());
+
+        if (write.blockSize1 > 0)
+            juce::FloatVectorOperations::copy(samples.data() + write.startIndex1, channelPtr, write.blockSize1);
+
+        if (write.blockSize2 > 0)
+            juce::FloatVectorOperations::copy(samples.data() + write.startIndex2, channelPtr + write.blockSize1, write.blockSize2);
     }
 
+    // Only drops the samples recorded at the previous rate; the storage never moves
     void prepare(int bufferSize) {
-        prepared.set(false);
         size.set(bufferSize);
-
-        bufferToFill.setSize(1, bufferSize, false, true, true);
-
-        audioBufferFifo.prepare(1, bufferSize);
-        fifoIndex = 0;
+        fifo.reset();
         prepared.set(true);
     }
 
-    /*****************************************************************/    
+    /*****************************************************************/
 
-    int getNumCompleteBuffersAvailable() const { return audioBufferFifo.getNumAvailableForReading(); }
+    int getNumSamplesAvailable() const { return fifo.getNumReady(); }
     bool isPrepared() const { return prepared.get(); }
     int getSize() const { return size.get(); }
 
     /*****************************************************************/
 
-    bool getAudioBuffer(BlockType& buf) { return audioBufferFifo.pull(buf); }
-
-private:
-    Channel channelToUse;
-    int fifoIndex = 0;
-    Fifo<BlockType> audioBufferFifo;
-    BlockType bufferToFill;
-    juce::Atomic<bool> prepared = false;
-    juce::Atomic<int> size = 0;
+    // Hands up to numToRead samples to callback(const float* data, int numSamples) straight
+    // out of the ring, in at most two calls, and returns the number of samples consumed.
+    template<typename Callback>
+    int read(int numToRead, Callback&& callback) {
+        auto read = fifo.read(numToRead);
 
-    void pushNextSampleIntoFifo(float sample) {
-        if (fifoIndex == bufferToFill.getNumSamples()) {
-            auto ok = audioBufferFifo.push(bufferToFill);
-            juce::ignoreUnused(ok);
+        if (read.blockSize1 > 0)
+            callback(samples.data() + read.startIndex1, read.blockSize1);
 
-            fifoIndex = 0;
-        }
+        if (read.blockSize2 > 0)
+            callback(samples.data() + read.startIndex2, read.blockSize2);
 
-        bufferToFill.setSample(0, fifoIndex, sample);
-        fifoIndex++;
+        return read.blockSize1 + read.blockSize2;
     }
 
+private:
+    // Several GUI frames worth of audio at 192 kHz, and four of the largest blocks hosts use
+    static constexpr int capacity = 1 << 17;
+
+    Channel channelToUse;
+    std::vector<float> samples;
+    juce::AbstractFifo fifo{ capacity };
+    juce::Atomic<bool> prepared = false;
+    juce::Atomic<int> size = 0;
 };
 
 enum Slope {
@@ -140,70 +187,194 @@ enum Slope {
     slope48
 };
 
+enum PeakDesign {
+    bilinearPeak,
+    matchedPeak
+};
+
+enum ParametricBandType {
+    peakBandType,
+    lowShelfBandType,
+    highShelfBandType,
+    notchBandType
+};
+
+struct ParametricBandSettings {
+    float frequency{ 1000.f }, gainInDB{ 0.f }, quality{ 1.f };
+    ParametricBandType type{ ParametricBandType::peakBandType };
+    bool byPassed{ true };
+};
+
+// Parameter IDs of one parametric band, built once so the audio thread never formats strings
+struct ParametricBandParameterIDs {
+    juce::String prefix, frequency, gain, quality, type, byPassed;
+};
+
+const ParametricBandParameterIDs& getParametricBandParameterIDs(int band);
+
 struct ChainSettings {
     float peakFreq{ 0 }, peakGainInDB{ 0 }, peakQuality{ 1.f };
     float lowCutFrequency{ 0 }, highCutFrequency{ 0 };
     Slope lowCutSlope{ Slope::slope12 }, highCutSlope{ Slope::slope12 };
     bool lowCutByPassed{ false }, peakByPassed{ false }, highCutByPassed{ false };
+    FilterTopology lowCutTopology{ FilterTopology::tdf2Float }, peakTopology{ FilterTopology::tdf2Float }, highCutTopology{ FilterTopology::tdf2Float };
+    PeakDesign peakDesign{ PeakDesign::bilinearPeak };
+
+    // Only the byPassed flag is read for bypassed bands
+    std::array<ParametricBandSettings, maxParametricBands> parametricBands;
 };
 
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);
+bool hasActiveParametricBands(const ChainSettings& chainSettings);
+
+// The parameters processBlock() reads every block, looked up once so it never searches by ID
+struct RawParameterValues {
+    explicit RawParameterValues(juce::AudioProcessorValueTreeState& apvts);
+
+    std::atomic<float>* lowCutFrequency;
+    std::atomic<float>* highCutFrequency;
+    std::atomic<float>* lowCutSlope;
+    std::atomic<float>* highCutSlope;
+    std::atomic<float>* peakFrequency;
+    std::atomic<float>* peakGain;
+    std::atomic<float>* peakQuality;
+    std::atomic<float>* lowCutByPassed;
+    std::atomic<float>* peakByPassed;
+    std::atomic<float>* highCutByPassed;
+    std::atomic<float>* lowCutTopology;
+    std::atomic<float>* peakTopology;
+    std::atomic<float>* highCutTopology;
+    std::atomic<float>* peakDesign;
+
+    struct ParametricBand {
+        std::atomic<float>* frequency;
+        std::atomic<float>* gain;
+        std::atomic<float>* quality;
+        std::atomic<float>* type;
+        std::atomic<float>* byPassed;
+    };
 
-using Filter = juce::dsp::IIR::Filter<float>;
+    std::array<ParametricBand, maxParametricBands> parametricBands;
 
-using CutFilter = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter>;
+    std::atomic<float>* phaseMode;
+    std::atomic<float>* oversampling;
+    std::atomic<float>* controlRate;
+    std::atomic<float>* testSignal;
+};
 
-using MonoChain = juce::dsp::ProcessorChain<CutFilter, Filter, CutFilter>;
+ChainSettings getChainSettings(const RawParameterValues& parameters);
 
 enum ChainPositions {
     LowCut,
     Peak,
-    HighCut
+    HighCut,
+    Parametric,
+    NumChainPositions
 };
 
-using Coefficients = Filter::CoefficientsPtr;
-void updateCoefficients(Coefficients& old, const Coefficients& new_);
+constexpr juce::uint32 bandMask(ChainPositions position) { return 1u << position; }
+constexpr juce::uint32 allBandsMask = bandMask(LowCut) | bandMask(Peak) | bandMask(HighCut) | bandMask(Parametric);
 
-Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate);
+juce::uint32 getBandMaskForParameter(const juce::String& parameterID);
 
-template<int Index, typename ChainType, typename CoefficientType>
-void update(ChainType& chain, const CoefficientType& coefficients) {
-    updateCoefficients(chain.template get<Index>().coefficients, coefficients[Index]);
-    chain.template setBypassed<Index>(false);
-}
+struct CoefficientSet {
+    CascadeCoefficients lowCut, peak, highCut;
+    ParametricBandCoefficients parametric;
+    FilterTopology lowCutTopology{ FilterTopology::tdf2Float }, peakTopology{ FilterTopology::tdf2Float }, highCutTopology{ FilterTopology::tdf2Float };
+    bool lowCutByPassed{ false }, peakByPassed{ false }, highCutByPassed{ false };
 
-template<typename ChainType, typename CoefficientType>
-void UpdateCutFilter(ChainType& chain, const CoefficientType& coefficients, const Slope& slope)
-{
-    chain.template setBypassed<0>(true);
-    chain.template setBypassed<1>(true);
-    chain.template setBypassed<2>(true);
-    chain.template setBypassed<3>(true);
-
-    switch (slope) {
-    case slope48:
-        update<3>(chain, coefficients);
-    case slope36:
-        update<2>(chain, coefficients);
-    case slope24:
-        update<1>(chain, coefficients);
-    case slope12:
-        update<0>(chain, coefficients);
-    }
-}
+    // Bumped every time the corresponding ChainPositions band is redesigned
+    std::array<juce::uint32, NumChainPositions> bandVersions{};
+    double sampleRate{ 0.0 };
+};
+
+void updateCoefficientSet(CoefficientSet& set, const ChainSettings& chainSettings, double sampleRate, juce::uint32 bandsToUpdate);
+
+BiquadCoefficients designParametricBand(const ParametricBandSettings& band, PeakDesign peakDesign, double sampleRate);
+
+// Ramps frequency, gain and Q towards their parameter values on the audio thread,
+// for the fixed bands and for every parametric band. While a band is ramping it is
+// redesigned every control step instead of waiting for the designer thread, which
+// only ever sees the final values. The parametric bank is redesigned as a whole.
+struct ParameterSmoother {
+    static constexpr double rampLengthSeconds = 0.05;
+
+    void prepare(double sampleRate, const ChainSettings& chainSettings);
 
-inline auto makeLowCutFilter(const ChainSettings& chainSettings, double sampleRate) {
-    return juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(chainSettings.lowCutFrequency, sampleRate, 2 * (chainSettings.lowCutSlope + 1));
-}
+    // Jumps straight to the values in chainSettings
+    void setCurrentAndTargetValues(const ChainSettings& chainSettings);
 
-inline auto makeHighCutFilter(const ChainSettings& chainSettings, double sampleRate) {
-    return juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(chainSettings.highCutFrequency, sampleRate, 2 * (chainSettings.highCutSlope + 1));
-}
+    // Returns the bands that are still ramping towards the new targets. Ramps last at
+    // least one block, so the once-per-block automation values hosts deliver for long
+    // blocks are joined by straight lines across the block instead of stepping at its start.
+    juce::uint32 setTargetValues(const ChainSettings& chainSettings, int numSamplesInBlock);
+
+    // Advances every ramp by numSamples and writes the values reached into chainSettings
+    void skip(int numSamples, ChainSettings& chainSettings);
+
+private:
+    using FrequencySmoother = juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative>;
+
+    FrequencySmoother lowCutFrequency, highCutFrequency, peakFrequency, peakQuality;
+    juce::SmoothedValue<float> peakGainInDB;
+
+    struct ParametricBandSmoother {
+        FrequencySmoother frequency, quality;
+        juce::SmoothedValue<float> gainInDB;
+
+        // Bypassed bands carry no values, so a band jumps to its values when it comes back
+        bool active{ false };
+    };
+
+    std::array<ParametricBandSmoother, maxParametricBands> parametricBands;
+
+    int minimumRampLength{ 0 }, rampLength{ 0 };
+
+    void setRampLength(int numSamples);
+};
+
+// Samples per coefficient update while smoothing, or 0 for "Off"
+int getControlRateInSamples(const RawParameterValues& parameters);
+
+// Designs coefficients away from the audio thread and publishes them through a TripleBuffer.
+// In linear phase mode it also designs the FIR kernel and hands it to the LinearPhaseFilter.
+struct CoefficientDesigner : juce::Thread {
+    CoefficientDesigner(const RawParameterValues& parameterValues, LinearPhaseFilter& filter);
+    ~CoefficientDesigner() override;
+
+    void setSampleRate(double newSampleRate);
+    void markDirty(juce::uint32 bands);
+
+    // Audio thread only
+    const CoefficientSet* getLatestCoefficients() { return coefficientSets.acquire(); }
+
+    void run() override;
+
+private:
+    const RawParameterValues& parameters;
+    LinearPhaseFilter& linearPhaseFilter;
+
+    std::atomic<juce::uint32> dirtyBands{ allBandsMask };
+    std::atomic<double> sampleRate{ 0.0 };
+
+    CoefficientSet staging;
+    TripleBuffer<CoefficientSet> coefficientSets;
+
+    LinearPhaseKernelDesigner kernelDesigner;
+    void designKernel(const CoefficientSet& coefficientSet);
+};
+
+bool isLinearPhase(const RawParameterValues& parameters);
+
+// Rate multiplier for the IIR bands; always 1 in linear phase mode, where there is no cramping
+int getOversamplingFactor(const RawParameterValues& parameters);
+constexpr int maxOversamplingFactor = 4;
 
 //==============================================================================
 /**
 */
-class KGP_EQAudioProcessor  : public juce::AudioProcessor
+class KGP_EQAudioProcessor  : public juce::AudioProcessor,
+                              private juce::AudioProcessorValueTreeState::Listener,
+                              private juce::Timer
 {
 public:
     //==============================================================================
@@ -245,26 +416,108 @@ public:
 
     static juce::AudioProcessorValueTreeState::ParameterLayout
         createParameterLayout();
+
+    // Up to 7.1.4, which also covers the 7.1.2 Atmos bed
+    static constexpr int maxNumChannels = 12;
     
     juce::AudioProcessorValueTreeState apvts{
         *this, nullptr, "Parameters", createParameterLayout()
     };
 
+    const RawParameterValues parameterValues{ apvts };
+
     using BlockType = juce::AudioBuffer<float>;
     SingleChannelSampleFifo<BlockType> leftChannelFifo{ Channel::Left };
     SingleChannelSampleFifo<BlockType> rightChannelFifo{ Channel::Right };
 
+    // Called by the editor; the analyzer FIFOs are only fed while one is attached
+    void setEditorAttached(bool isAttached) { setAnalyzerConsumer(editorAttachedBit, isAttached); }
+
+    // Share of the block period spent in processBlock, smoothed over recent blocks
+    double getDSPLoad() const { return loadMeasurer.getLoadAsProportion(); }
+    int getXRunCount() const { return loadMeasurer.getXRunCount(); }
+
+    // Per block timing histogram and the allocation trap, see AudioThreadMonitor.h
+    AudioThreadMonitor& getAudioThreadMonitor() { return audioThreadMonitor; }
+
 private:
 
-    MonoChain lChain, rChain;
+    FilterEngine filterEngine;
+
+    // Declared before the designer, which holds a reference to it
+    LinearPhaseFilter linearPhaseFilter;
+    bool linearPhaseActive{ false };
+
+    void updateFilters(const CoefficientSet& coefficientSet, juce::uint32 bandsToUpdate);
+
+    void parameterChanged(const juce::String& parameterID, float newValue) override;
+
+    // Set while setStateInformation() applies a state, which silences parameterChanged()
+    std::atomic<bool> restoringState{ false };
+
+    // The restored bands are redesigned by the next prepareToPlay() or processBlock()
+    std::atomic<bool> stateRestorePending{ false };
+
+    CoefficientDesigner coefficientDesigner{ parameterValues, linearPhaseFilter };
+    std::array<juce::uint32, NumChainPositions> appliedBandVersions{};
+
+    ParameterSmoother parameterSmoother;
+    CoefficientSet smoothedCoefficients;
+
+    // Input below this on every channel counts as silence
+    static constexpr float silenceThreshold = 1.0e-7f;
+
+    // The analyzer FIFOs are fed only while an editor is open and the analyzer is enabled
+    enum : juce::uint32 {
+        editorAttachedBit = 1u << 0,
+        analyzerEnabledBit = 1u << 1,
+        allAnalyzerConsumerBits = editorAttachedBit | analyzerEnabledBit
+    };
+
+    std::atomic<juce::uint32> analyzerConsumers{ 0 };
+
+    void setAnalyzerConsumer(juce::uint32 bit, bool isConsuming);
+    std::atomic<double> tailLengthSeconds{ 0.0 };
+
+    // Samples of silence still to run through the filters before they can be skipped
+    int tailSamplesRemaining{ 0 };
+    bool filterStateFlushed{ false };
+
+    bool isInputSilent(const juce::AudioBuffer<float>& buffer) const;
+
+    int getActiveTailLengthInSamples() const;
+
+    // Message thread. Any other thread calls requestLatencyUpdate(), which only sets
+    // latencyUpdatePending; posting a message could lock or allocate on the audio thread,
+    // so timerCallback() polls the flag instead.
+    void updateLatency();
+    void requestLatencyUpdate();
+    void timerCallback() override;
+
+    std::atomic<bool> latencyUpdatePending{ false };
+    static constexpr int latencyPollHz = 10;
+
+    // Index 0 is 2x, index 1 is 4x
+    std::array<std::unique_ptr<juce::dsp::Oversampling<float>>, 2> oversamplers;
+
+    // Copied out in prepareToPlay(), so updateLatency() never touches the oversamplers
+    std::array<std::atomic<int>, 2> oversamplerLatencies{};
+    int activeOversamplingFactor{ 1 };
+
+    double getProcessingSampleRate() const { return getSampleRate() * activeOversamplingFactor; }
+    juce::dsp::Oversampling<float>* getActiveOversampler() const;
+
+    // Audio thread; the bands are redesigned in place so they never run at the wrong rate
+    void setOversamplingFactor(int factor, const ChainSettings& chainSettings);
+
+    void processFilters(juce::dsp::AudioBlock<float>& block, const ChainSettings& chainSettings,
+                        juce::uint32 rampingBands, int controlRate);
 
-    void updatePeakFilter(const ChainSettings& chainSettings);
- 
-    void updateLowCutFilter(const ChainSettings& chainSettings);
-    void updateHighCutFilter(const ChainSettings& chainSettings);
-    void updateFilters();
+    juce::AudioProcessLoadMeasurer loadMeasurer;
+    AudioThreadMonitor audioThreadMonitor;
 
-    juce::dsp::Oscillator<float> osc;
+    TestSignalGenerator testSignalGenerator;
+    TestSignal activeTestSignal{ TestSignal::testSignalOff };
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (KGP_EQAudioProcessor)
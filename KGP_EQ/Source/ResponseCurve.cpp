@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+    ResponseCurve.cpp
+
+  ==============================================================================
+*/
+
+#include "ResponseCurve.h"
+
+void computeHalfAngleSines(const float* frequencies, int numFrequencies, double sampleRate, float* sinesOut) {
+    for (int i = 0; i < numFrequencies; ++i) {
+        auto s = std::sin(juce::MathConstants<double>::pi * frequencies[i] / sampleRate);
+        sinesOut[i] = (float)(s * s);
+    }
+}
+
+void computeMagnitudesInDecibels(const float* halfAngleSines, int numFrequencies,
+                                 const BiquadCoefficients* biquads, int numBiquads,
+                                 float* decibelsOut) {
+    constexpr float minimumPower = 1.0e-20f;
+
+    std::fill(decibelsOut, decibelsOut + numFrequencies, 1.f);
+
+    for (int stage = 0; stage < numBiquads; ++stage) {
+        const auto& c = biquads[stage];
+
+        // The sums are formed in double, so sections with a zero at DC or Nyquist stay exact
+        const auto n0 = (float)((c.b0 + c.b1 + c.b2) * (c.b0 + c.b1 + c.b2));
+        const auto n1 = (float)(-4.0 * (c.b0 * c.b1 + 4.0 * c.b0 * c.b2 + c.b1 * c.b2));
+        const auto n2 = (float)(16.0 * c.b0 * c.b2);
+
+        const auto d0 = (float)((1.0 + c.a1 + c.a2) * (1.0 + c.a1 + c.a2));
+        const auto d1 = (float)(-4.0 * (c.a1 + 4.0 * c.a2 + c.a1 * c.a2));
+        const auto d2 = (float)(16.0 * c.a2);
+
+        for (int i = 0; i < numFrequencies; ++i) {
+            const auto p = halfAngleSines[i];
+            const auto numerator = n0 + p * (n1 + p * n2);
+            const auto denominator = d0 + p * (d1 + p * d2);
+
+            decibelsOut[i] = clampToPositiveMinimum(decibelsOut[i] * numerator / denominator, minimumPower);
+        }
+    }
+
+    for (int i = 0; i < numFrequencies; ++i)
+        decibelsOut[i] = fastPowerToDecibels(decibelsOut[i]);
+}
+
+bool ResponseCurveEngine::prepare(int newNumColumns, double newSampleRate) {
+    if (newNumColumns == numColumns && newSampleRate == sampleRate)
+        return false;
+
+    numColumns = juce::jmax(0, newNumColumns);
+    sampleRate = newSampleRate;
+
+    frequencies.resize(numColumns);
+    halfAngleSines.resize(numColumns);
+
+    for (int i = 0; i < numColumns; ++i)
+        frequencies[i] = (float)juce::mapToLog10(double(i) / double(numColumns), 20.0, 20000.0);
+
+    computeHalfAngleSines(frequencies.data(), numColumns, sampleRate, halfAngleSines.data());
+
+    for (auto& band : bandDecibels)
+        band.assign(numColumns, 0.f);
+
+    totalDecibels.assign(numColumns, 0.f);
+    totalNeedsUpdate = true;
+
+    return true;
+}
+
+void ResponseCurveEngine::setBand(int band, const CascadeCoefficients& coefficients, bool bypassed) {
+    setBand(band, coefficients.stages.data(), bypassed ? 0 : coefficients.numStages);
+}
+
+void ResponseCurveEngine::setBand(int band, const BiquadCoefficients* sections, int numSections) {
+    jassert(juce::isPositiveAndBelow(band, numBands));
+
+    auto& decibels = bandDecibels[band];
+    totalNeedsUpdate = true;
+
+    if (numSections == 0) {
+        std::fill(decibels.begin(), decibels.end(), 0.f);
+        return;
+    }
+
+    computeMagnitudesInDecibels(halfAngleSines.data(), numColumns, sections, numSections, decibels.data());
+}
+
+const std::vector<float>& ResponseCurveEngine::getMagnitudesInDecibels() {
+    if (totalNeedsUpdate && numColumns > 0) {
+        juce::FloatVectorOperations::copy(totalDecibels.data(), bandDecibels[0].data(), numColumns);
+
+        for (int band = 1; band < numBands; ++band)
+            juce::FloatVectorOperations::add(totalDecibels.data(), bandDecibels[band].data(), numColumns);
+    }
+
+    totalNeedsUpdate = false;
+    return totalDecibels;
+}
@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    ResponseCurve.h
+
+    Batch magnitude evaluation of biquad cascades, and the response curve
+    engine built on it. The engine samples one frequency per pixel column,
+    tabulates the frequency dependent term once per width and sample rate,
+    and caches each band's curve so changing one band only re-evaluates
+    that band.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "CoefficientDesign.h"
+#include "FastMath.h"
+
+// sin^2(w / 2) for every frequency, the only per frequency input computeMagnitudesInDecibels needs
+void computeHalfAngleSines(const float* frequencies, int numFrequencies, double sampleRate, float* sinesOut);
+
+// Combined magnitude in dB of numBiquads cascaded sections at every frequency, evaluated as
+//   |H|^2 = ((b0 + b1 + b2)^2 - 4 (b0 b1 + 4 b0 b2 + b1 b2) p + 16 b0 b2 p^2) / (same in a)
+// with p = sin^2(w / 2). This form keeps float accuracy near DC and Nyquist. Results are
+// floored at -200 dB.
+//
+// There are no explicit intrinsics; the loops are written for the auto-vectoriser (no branches,
+// no cross-iteration dependency, integer clamp and log2 from FastMath.h). Measured for 1200
+// columns x 25 sections on x86-64 with GCC 12: 17 us at -O3 (both loops vectorised per
+// -fopt-info-vec), 53 us with -fno-tree-vectorize or at -O2, 8.5 us with AVX2, against 450 us
+// for a per frequency complex evaluation. The benchmark prints the figure for other compilers.
+void computeMagnitudesInDecibels(const float* halfAngleSines, int numFrequencies,
+                                 const BiquadCoefficients* biquads, int numBiquads,
+                                 float* decibelsOut);
+
+class ResponseCurveEngine {
+public:
+    static constexpr int numBands = 4;
+
+    // Rebuilds the frequency table when the width or sample rate changed.
+    // Returns true in that case, and every band has to be set again.
+    bool prepare(int numColumns, double sampleRate);
+
+    void setBand(int band, const CascadeCoefficients& coefficients, bool bypassed);
+
+    // Any number of cascaded sections as one band; none is a flat band
+    void setBand(int band, const BiquadCoefficients* sections, int numSections);
+
+    // Sum of all band curves, one value in dB per column
+    const std::vector<float>& getMagnitudesInDecibels();
+
+    int getNumColumns() const { return numColumns; }
+
+private:
+    int numColumns = 0;
+    double sampleRate = 0.0;
+
+    std::vector<float> frequencies, halfAngleSines;
+
+    std::array<std::vector<float>, numBands> bandDecibels;
+    std::vector<float> totalDecibels;
+    bool totalNeedsUpdate = true;
+};
@@ -0,0 +1,269 @@
+/*
+  ==============================================================================
+
+    ResponseCurveGL.cpp
+
+  ==============================================================================
+*/
+
+#include "ResponseCurveGL.h"
+
+#if KGP_EQ_ENABLE_OPENGL
+
+using namespace juce::gl;
+
+namespace {
+    // Frames to wait for the context before giving up on OpenGL
+    constexpr int maxFramesWithoutContext = 60;
+
+    const char* lineVertexShader =
+        "attribute vec2 position;\n"
+        "uniform vec2 viewSize;\n"
+        "void main()\n"
+        "{\n"
+        "    gl_Position = vec4(position.x / viewSize.x * 2.0 - 1.0, 1.0 - position.y / viewSize.y * 2.0, 0.0, 1.0);\n"
+        "}\n";
+
+    const char* lineFragmentShader =
+        "uniform " JUCE_MEDIUMP " vec4 colour;\n"
+        "void main()\n"
+        "{\n"
+        "    gl_FragColor = colour;\n"
+        "}\n";
+
+    // position runs over the unit square. OpenGLTexture::loadImage stores the image flipped and
+    // anchored to the top of the texture, so textureScale shrinks towards the top left corner
+    // when the texture had to be padded to a power of two.
+    const char* layerVertexShader =
+        "attribute vec2 position;\n"
+        "uniform vec2 textureScale;\n"
+        "varying vec2 textureCoordinate;\n"
+        "void main()\n"
+        "{\n"
+        "    textureCoordinate = vec2(position.x * textureScale.x, 1.0 - (1.0 - position.y) * textureScale.y);\n"
+        "    gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);\n"
+        "}\n";
+
+    const char* layerFragmentShader =
+        "uniform sampler2D layer;\n"
+        "varying " JUCE_MEDIUMP " vec2 textureCoordinate;\n"
+        "void main()\n"
+        "{\n"
+        "    gl_FragColor = texture2D(layer, textureCoordinate);\n"
+        "}\n";
+
+    std::unique_ptr<juce::OpenGLShaderProgram> makeShader(juce::OpenGLContext& context,
+                                                          const char* vertexShader,
+                                                          const char* fragmentShader) {
+        auto shader = std::make_unique<juce::OpenGLShaderProgram>(context);
+
+        if (shader->addVertexShader(juce::OpenGLHelpers::translateVertexShaderToV3(vertexShader))
+            && shader->addFragmentShader(juce::OpenGLHelpers::translateFragmentShaderToV3(fragmentShader))
+            && shader->link())
+            return shader;
+
+        DBG("ResponseCurveGLRenderer: " << shader->getLastError());
+        return nullptr;
+    }
+}
+
+ResponseCurveGLRenderer::ResponseCurveGLRenderer() {
+    context.setRenderer(this);
+    context.setComponentPaintingEnabled(false);
+    context.setContinuousRepainting(false);
+}
+
+ResponseCurveGLRenderer::~ResponseCurveGLRenderer() {
+    detach();
+}
+
+void ResponseCurveGLRenderer::attachTo(juce::Component& component) {
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    if (attachedComponent == &component)
+        return;
+
+    detach();
+
+    framesWithoutContext = 0;
+    failed.store(false);
+
+    context.attachTo(component);
+    attachedComponent = &component;
+}
+
+void ResponseCurveGLRenderer::detach() {
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    if (attachedComponent == nullptr)
+        return;
+
+    context.detach();
+    attachedComponent = nullptr;
+}
+
+bool ResponseCurveGLRenderer::hasFailed() {
+    if (isAttached() && !contextCreated.load() && ++framesWithoutContext > maxFramesWithoutContext)
+        failed.store(true);
+
+    return failed.load();
+}
+
+void ResponseCurveGLRenderer::setLayers(const juce::Image& background, const juce::Image& foreground) {
+    const juce::ScopedLock lock(dataLock);
+
+    backgroundImage = background;
+    foregroundImage = foreground;
+    layersChanged = true;
+}
+
+void ResponseCurveGLRenderer::setLine(Line line, const juce::Path& path, juce::Point<float> offset, juce::Colour colour, float width) {
+    const juce::ScopedLock lock(dataLock);
+
+    auto& data = lines[line];
+    data.vertices.clear();
+
+    // The analyzer and response paths are polylines, so their points are the vertices
+    for (juce::Path::Iterator it(path); it.next();) {
+        if (it.elementType == juce::Path::Iterator::startNewSubPath || it.elementType == juce::Path::Iterator::lineTo) {
+            data.vertices.push_back(it.x1 + offset.x);
+            data.vertices.push_back(it.y1 + offset.y);
+        }
+    }
+
+    data.colour = colour;
+    data.width = width;
+    data.visible = true;
+}
+
+void ResponseCurveGLRenderer::hideLine(Line line) {
+    const juce::ScopedLock lock(dataLock);
+    lines[line].visible = false;
+}
+
+void ResponseCurveGLRenderer::newOpenGLContextCreated() {
+    if (!buildShaders()) {
+        failed.store(true);
+        return;
+    }
+
+    glGenBuffers(1, &vertexBuffer);
+    contextCreated.store(true);
+}
+
+bool ResponseCurveGLRenderer::buildShaders() {
+    lineShader = makeShader(context, lineVertexShader, lineFragmentShader);
+    layerShader = makeShader(context, layerVertexShader, layerFragmentShader);
+
+    return lineShader != nullptr && layerShader != nullptr;
+}
+
+void ResponseCurveGLRenderer::openGLContextClosing() {
+    lineShader.reset();
+    layerShader.reset();
+
+    backgroundTexture.release();
+    foregroundTexture.release();
+
+    if (vertexBuffer != 0)
+        glDeleteBuffers(1, &vertexBuffer);
+
+    vertexBuffer = 0;
+    contextCreated.store(false);
+}
+
+void ResponseCurveGLRenderer::renderOpenGL() {
+    if (failed.load() || lineShader == nullptr || layerShader == nullptr)
+        return;
+
+    {
+        const juce::ScopedLock lock(dataLock);
+
+        if (layersChanged) {
+            backgroundTexture.loadImage(backgroundImage);
+            foregroundTexture.loadImage(foregroundImage);
+            layerSize = backgroundImage.getBounds();
+            layersChanged = false;
+        }
+
+        renderLines = lines;
+    }
+
+    auto scale = (float)context.getRenderingScale();
+    auto* component = context.getTargetComponent();
+    if (component == nullptr)
+        return;
+
+    auto width = (float)component->getWidth();
+    auto height = (float)component->getHeight();
+
+    glViewport(0, 0, juce::roundToInt(width * scale), juce::roundToInt(height * scale));
+    juce::OpenGLHelpers::clear(juce::Colours::black);
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);   // juce::Image pixels are premultiplied
+
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+
+    if (!layerSize.isEmpty())
+        drawLayer(backgroundTexture);
+
+    for (auto& line : renderLines)
+        drawLine(line, width, height, scale);
+
+    if (!layerSize.isEmpty())
+        drawLayer(foregroundTexture);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void ResponseCurveGLRenderer::drawLayer(juce::OpenGLTexture& texture) {
+    static const float quad[] = { 0.f, 0.f, 1.f, 0.f, 0.f, 1.f, 1.f, 1.f };
+
+    layerShader->use();
+
+    juce::OpenGLShaderProgram::Uniform(*layerShader, "layer").set(0);
+    juce::OpenGLShaderProgram::Uniform(*layerShader, "textureScale")
+        .set(layerSize.getWidth() / (float)texture.getWidth(), layerSize.getHeight() / (float)texture.getHeight());
+
+    glActiveTexture(GL_TEXTURE0);
+    texture.bind();
+
+    auto position = (GLuint)juce::OpenGLShaderProgram::Attribute(*layerShader, "position").attributeID;
+
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STREAM_DRAW);
+    glVertexAttribPointer(position, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+    glEnableVertexAttribArray(position);
+
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    glDisableVertexAttribArray(position);
+    texture.unbind();
+}
+
+void ResponseCurveGLRenderer::drawLine(const LineData& line, float width, float height, float scale) {
+    if (!line.visible || line.vertices.size() < 4)
+        return;
+
+    lineShader->use();
+
+    juce::OpenGLShaderProgram::Uniform(*lineShader, "viewSize").set(width, height);
+
+    auto colour = line.colour;
+    juce::OpenGLShaderProgram::Uniform(*lineShader, "colour")
+        .set(colour.getFloatRed(), colour.getFloatGreen(), colour.getFloatBlue(), colour.getFloatAlpha());
+
+    auto position = (GLuint)juce::OpenGLShaderProgram::Attribute(*lineShader, "position").attributeID;
+
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(line.vertices.size() * sizeof(float)), line.vertices.data(), GL_STREAM_DRAW);
+    glVertexAttribPointer(position, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+    glEnableVertexAttribArray(position);
+
+    // Wide lines are optional in GL; drivers without them draw one pixel lines
+    glLineWidth(line.width * scale);
+    glDrawArrays(GL_LINE_STRIP, 0, (GLsizei)(line.vertices.size() / 2));
+
+    glDisableVertexAttribArray(position);
+}
+
+#endif
@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    ResponseCurveGL.h
+
+    Optional OpenGL backend for the response curve component. The cached
+    background and foreground layers are drawn as textures, and the analyzer
+    and response polylines are uploaded as vertex buffers and drawn with a
+    flat colour shader. If the context or the shaders can't be set up,
+    hasFailed() reports it and the component falls back to software paint().
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+#ifndef KGP_EQ_ENABLE_OPENGL
+ #define KGP_EQ_ENABLE_OPENGL JUCE_MODULE_AVAILABLE_juce_opengl
+#endif
+
+#if KGP_EQ_ENABLE_OPENGL
+
+class ResponseCurveGLRenderer : private juce::OpenGLRenderer {
+public:
+    enum Line {
+        leftSpectrum,
+        rightSpectrum,
+        response,
+        numLines
+    };
+
+    ResponseCurveGLRenderer();
+    ~ResponseCurveGLRenderer() override;
+
+    // Message thread only
+    void attachTo(juce::Component& component);
+    void detach();
+    bool isAttached() const { return attachedComponent != nullptr; }
+
+    // True once the context failed to appear or the shaders failed to build
+    bool hasFailed();
+
+    float getRenderingScale() const { return (float)context.getRenderingScale(); }
+
+    void setLayers(const juce::Image& background, const juce::Image& foreground);
+    void setLine(Line line, const juce::Path& path, juce::Point<float> offset, juce::Colour colour, float width);
+    void hideLine(Line line);
+
+    void triggerRepaint() { context.triggerRepaint(); }
+
+private:
+    void newOpenGLContextCreated() override;
+    void renderOpenGL() override;
+    void openGLContextClosing() override;
+
+    struct LineData {
+        std::vector<float> vertices;   // x, y pairs in component coordinates
+        juce::Colour colour;
+        float width{ 1.f };
+        bool visible{ false };
+    };
+
+    juce::OpenGLContext context;
+    juce::Component* attachedComponent = nullptr;
+
+    // Handed from the message thread to the render thread
+    juce::CriticalSection dataLock;
+    std::array<LineData, numLines> lines;
+    juce::Image backgroundImage, foregroundImage;
+    bool layersChanged = false;
+
+    std::atomic<bool> contextCreated{ false }, failed{ false };
+    int framesWithoutContext = 0;
+
+    // Render thread only
+    std::array<LineData, numLines> renderLines;
+    std::unique_ptr<juce::OpenGLShaderProgram> lineShader, layerShader;
+    juce::OpenGLTexture backgroundTexture, foregroundTexture;
+    juce::uint32 vertexBuffer = 0;
+    juce::Rectangle<int> layerSize;
+
+    bool buildShaders();
+    void drawLayer(juce::OpenGLTexture& texture);
+    void drawLine(const LineData& line, float width, float height, float scale);
+
+    JUCE_DECLARE_NON_COPYABLE(ResponseCurveGLRenderer)
+};
+
+#endif
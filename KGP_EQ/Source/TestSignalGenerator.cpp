@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+
+    TestSignalGenerator.cpp
+
+  ==============================================================================
+*/
+
+#include "TestSignalGenerator.h"
+
+void TestSignalGenerator::prepare(double newSampleRate) {
+    sampleRate = newSampleRate;
+    sweepRatio = std::pow(sweepEndFrequency / sweepStartFrequency, 1.0 / (sweepLengthSeconds * sampleRate));
+
+    reset();
+}
+
+void TestSignalGenerator::reset() {
+    sweepPhase = 0.0;
+    sweepFrequency = sweepStartFrequency;
+
+    random.setSeed(noiseSeed);
+    pinkState.fill(0.f);
+
+    samplesUntilImpulse = 0;
+}
+
+void TestSignalGenerator::process(TestSignal signal, juce::AudioBuffer<float>& buffer) {
+    const auto numSamples = buffer.getNumSamples();
+    if (buffer.getNumChannels() == 0 || numSamples == 0)
+        return;
+
+    auto* data = buffer.getWritePointer(0);
+
+    switch (signal) {
+    case TestSignal::sineSweep:
+        generateSweep(data, numSamples);
+        break;
+    case TestSignal::pinkNoise:
+        generatePinkNoise(data, numSamples);
+        break;
+    case TestSignal::impulse:
+        generateImpulses(data, numSamples);
+        break;
+    case TestSignal::testSignalOff:
+    default:
+        return;
+    }
+
+    for (int channel = 1; channel < buffer.getNumChannels(); channel++)
+        buffer.copyFrom(channel, 0, data, numSamples);
+}
+
+void TestSignalGenerator::generateSweep(float* data, int numSamples) {
+    const auto twoPiOverSampleRate = juce::MathConstants<double>::twoPi / sampleRate;
+
+    for (int i = 0; i < numSamples; i++) {
+        data[i] = level * (float)std::sin(sweepPhase);
+
+        sweepPhase += sweepFrequency * twoPiOverSampleRate;
+        if (sweepPhase >= juce::MathConstants<double>::twoPi)
+            sweepPhase -= juce::MathConstants<double>::twoPi;
+
+        sweepFrequency *= sweepRatio;
+        if (sweepFrequency >= sweepEndFrequency)
+            sweepFrequency = sweepStartFrequency;
+    }
+}
+
+void TestSignalGenerator::generatePinkNoise(float* data, int numSamples) {
+    auto& b = pinkState;
+
+    // The filter output has an RMS of about 1.77, scale it to the same RMS as the sweep
+    constexpr float outputGain = 0.4f;
+
+    for (int i = 0; i < numSamples; i++) {
+        auto white = random.nextFloat() * 2.f - 1.f;
+
+        b[0] = 0.99886f * b[0] + white * 0.0555179f;
+        b[1] = 0.99332f * b[1] + white * 0.0750759f;
+        b[2] = 0.96900f * b[2] + white * 0.1538520f;
+        b[3] = 0.86650f * b[3] + white * 0.3104856f;
+        b[4] = 0.55000f * b[4] + white * 0.5329522f;
+        b[5] = -0.7616f * b[5] - white * 0.0168980f;
+
+        auto pink = b[0] + b[1] + b[2] + b[3] + b[4] + b[5] + b[6] + white * 0.5362f;
+        b[6] = white * 0.115926f;
+
+        data[i] = level * outputGain * pink;
+    }
+}
+
+void TestSignalGenerator::generateImpulses(float* data, int numSamples) {
+    std::fill(data, data + numSamples, 0.f);
+
+    const auto interval = juce::jmax(1, juce::roundToInt(impulseIntervalSeconds * sampleRate));
+
+    for (int i = samplesUntilImpulse; i < numSamples; i += interval)
+        data[i] = level;
+
+    // Distance from the end of this block to the next impulse
+    auto remaining = (samplesUntilImpulse - numSamples) % interval;
+    samplesUntilImpulse = remaining < 0 ? remaining + interval : remaining;
+}
@@ -0,0 +1,57 @@
+/*
+  ==============================================================================
+
+    TestSignalGenerator.h
+
+    Reproducible internal test signals that can replace the plugin input, for
+    measuring the filter response, the analyzer and the CPU cost without a
+    signal generator in the host.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+enum TestSignal {
+    testSignalOff,
+    sineSweep,
+    pinkNoise,
+    impulse
+};
+
+class TestSignalGenerator {
+public:
+    static constexpr float level = 0.25f;   // -12 dBFS, leaves room for a boosted band
+    static constexpr double sweepStartFrequency = 20.0;
+    static constexpr double sweepEndFrequency = 20000.0;
+    static constexpr double sweepLengthSeconds = 10.0;
+    static constexpr double impulseIntervalSeconds = 1.0;
+
+    void prepare(double sampleRate);
+
+    // Restarts every signal, so the same sequence comes out after each reset
+    void reset();
+
+    // Overwrites every channel of the buffer with the selected signal
+    void process(TestSignal signal, juce::AudioBuffer<float>& buffer);
+
+private:
+    double sampleRate{ 44100.0 };
+
+    // Exponential sweep: the frequency is multiplied by sweepRatio every sample
+    double sweepPhase{ 0.0 }, sweepFrequency{ sweepStartFrequency }, sweepRatio{ 1.0 };
+
+    // Paul Kellet's refined pink noise filter
+    static constexpr juce::int64 noiseSeed = 0x4b475045;
+    juce::Random random{ noiseSeed };
+    std::array<float, 7> pinkState{};
+
+    int samplesUntilImpulse{ 0 };
+
+    void generateSweep(float* data, int numSamples);
+    void generatePinkNoise(float* data, int numSamples);
+    void generateImpulses(float* data, int numSamples);
+};